@@ -0,0 +1,350 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include <cstdint>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Аллокатор, умеющий расширять уже выделенный блок на месте. Небольшие блоки выделяются
+// через malloc и растут через realloc, блоки от MAP_THRESHOLD байт на Linux отображаются
+// напрямую через mmap и растут через mremap, что сводится к обновлению таблицы страниц
+// без копирования данных.
+// Функция reallocate переносит содержимое блока побайтово, поэтому RawMemory вызывает её
+// только для тривиально перемещаемых типов
+template <typename T>
+class ReallocatingAllocator {
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    // Порог, начиная с которого блок отображается в память отдельно от кучи
+    static constexpr size_t MAP_THRESHOLD = size_t{1} << 20;
+
+    ReallocatingAllocator() = default;
+
+    template <typename U>
+    ReallocatingAllocator(const ReallocatingAllocator<U>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        const size_t bytes = BytesFor(n);
+#if defined(__linux__)
+        if (bytes >= MAP_THRESHOLD) {
+            return static_cast<T*>(Map(bytes));
+        }
+#endif
+        void* ptr = std::malloc(bytes);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+#if defined(__linux__)
+        const size_t bytes = n * sizeof(T);
+        if (bytes >= MAP_THRESHOLD) {
+            munmap(ptr, RoundUpToPage(bytes));
+            return;
+        }
+#else
+        (void)n;
+#endif
+        std::free(ptr);
+    }
+
+    // Изменяет размер блока ptr с old_n до new_n элементов, по возможности на месте.
+    // При нехватке памяти выбрасывает std::bad_alloc, оставляя исходный блок нетронутым
+    T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+        const size_t old_bytes = old_n * sizeof(T);
+        const size_t new_bytes = BytesFor(new_n);
+#if defined(__linux__)
+        if (old_bytes >= MAP_THRESHOLD && new_bytes >= MAP_THRESHOLD) {
+            void* new_ptr = mremap(ptr, RoundUpToPage(old_bytes), RoundUpToPage(new_bytes), MREMAP_MAYMOVE);
+            if (new_ptr == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(new_ptr);
+        }
+        if (old_bytes >= MAP_THRESHOLD || new_bytes >= MAP_THRESHOLD) {
+            // Блок переходит между кучей и отдельным отображением, копирования не избежать
+            T* new_ptr = allocate(new_n);
+            std::memcpy(static_cast<void*>(new_ptr), ptr, std::min(old_bytes, new_bytes));
+            deallocate(ptr, old_n);
+            return new_ptr;
+        }
+#else
+        (void)old_bytes;
+#endif
+        void* new_ptr = std::realloc(static_cast<void*>(ptr), new_bytes);
+        if (new_ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(new_ptr);
+    }
+
+    friend bool operator==(const ReallocatingAllocator& /*lhs*/, const ReallocatingAllocator& /*rhs*/) noexcept {
+        return true;
+    }
+
+    friend bool operator!=(const ReallocatingAllocator& /*lhs*/, const ReallocatingAllocator& /*rhs*/) noexcept {
+        return false;
+    }
+
+private:
+    static size_t BytesFor(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return n * sizeof(T);
+    }
+
+#if defined(__linux__)
+    static size_t RoundUpToPage(size_t bytes) noexcept {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (bytes + page_size - 1) / page_size * page_size;
+    }
+
+    static void* Map(size_t bytes) {
+        void* ptr = mmap(nullptr, RoundUpToPage(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+#endif
+};
+
+// Вид страниц, которыми HugePageAllocator отображает крупные блоки
+enum class PageKind {
+    // Обычные страницы, отображение нужно только для размещения по узлам NUMA
+    REGULAR,
+    // Обычное отображение с madvise(MADV_HUGEPAGE): ядро соберёт его в прозрачные
+    // огромные страницы, если они включены
+    TRANSPARENT_HUGE,
+    // Явные огромные страницы MAP_HUGETLB заданного размера. Если свободных огромных
+    // страниц нет, блок отображается как TRANSPARENT_HUGE
+    HUGE_2MB,
+    HUGE_1GB,
+};
+
+// Размещение страниц блока по узлам NUMA
+enum class NumaPolicy {
+    // Страницы достаются узлу потока, первым коснувшегося их
+    LOCAL,
+    // Страницы выделяются только на узлах из node_mask
+    BIND,
+    // Страницы распределяются по узлам из node_mask поочерёдно
+    INTERLEAVE,
+};
+
+struct PageOptions {
+    PageKind page_kind = PageKind::TRANSPARENT_HUGE;
+    NumaPolicy numa_policy = NumaPolicy::LOCAL;
+    // Битовая маска узлов NUMA для BIND и INTERLEAVE, бит i соответствует узлу i
+    uint64_t node_mask = 0;
+    // Блоки меньше этого размера выделяются через operator new
+    size_t min_mapped_bytes = size_t{2} << 20;
+};
+
+// Аллокатор крупных буферов на огромных страницах с размещением по узлам NUMA.
+// Блоки от PageOptions::min_mapped_bytes отображаются через mmap, их длина округляется
+// до размера страницы выбранного вида. Недоступные возможности не приводят к ошибке:
+// без свободных MAP_HUGETLB-страниц блок отображается обычными страницами, отказ mbind
+// (ядро без NUMA, запрет в контейнере) оставляет размещение по умолчанию, а на системах
+// без mmap все блоки выделяются через operator new
+template <typename T>
+class HugePageAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    HugePageAllocator() = default;
+
+    explicit HugePageAllocator(const PageOptions& options) noexcept : options_(options) {
+    }
+
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U>& other) noexcept : options_(other.GetOptions()) {
+    }
+
+    const PageOptions& GetOptions() const noexcept {
+        return options_;
+    }
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        const size_t bytes = n * sizeof(T);
+#if defined(__linux__)
+        if (IsMapped(bytes)) {
+            return static_cast<T*>(Map(bytes));
+        }
+#endif
+        return static_cast<T*>(::operator new(bytes, std::align_val_t{alignof(T)}));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        const size_t bytes = n * sizeof(T);
+#if defined(__linux__)
+        if (IsMapped(bytes)) {
+            munmap(ptr, RoundUpToPage(bytes));
+            return;
+        }
+#endif
+        ::operator delete(ptr, std::align_val_t{alignof(T)});
+    }
+
+    // Блоки, отображённые с одинаковым видом страниц и порогом, освобождаются одинаково
+    friend bool operator==(const HugePageAllocator& lhs, const HugePageAllocator& rhs) noexcept {
+        return lhs.options_.page_kind == rhs.options_.page_kind
+            && lhs.options_.min_mapped_bytes == rhs.options_.min_mapped_bytes;
+    }
+
+    friend bool operator!=(const HugePageAllocator& lhs, const HugePageAllocator& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    // Размер страницы, до которого округляется длина отображения
+    size_t PageBytes() const noexcept {
+        switch (options_.page_kind) {
+        case PageKind::HUGE_1GB:
+            return size_t{1} << 30;
+        case PageKind::HUGE_2MB:
+        case PageKind::TRANSPARENT_HUGE:
+            return size_t{2} << 20;
+        case PageKind::REGULAR:
+            break;
+        }
+#if defined(__linux__)
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+    }
+
+private:
+    bool IsMapped(size_t bytes) const noexcept {
+        return bytes != 0 && bytes >= options_.min_mapped_bytes;
+    }
+
+#if defined(__linux__)
+    size_t RoundUpToPage(size_t bytes) const noexcept {
+        const size_t page_bytes = PageBytes();
+        return (bytes + page_bytes - 1) / page_bytes * page_bytes;
+    }
+
+    void* Map(size_t bytes) const {
+        if (bytes > std::numeric_limits<size_t>::max() - PageBytes()) {
+            throw std::bad_alloc();
+        }
+        const size_t length = RoundUpToPage(bytes);
+        void* ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+        if (options_.page_kind == PageKind::HUGE_2MB || options_.page_kind == PageKind::HUGE_1GB) {
+            const int page_shift = options_.page_kind == PageKind::HUGE_2MB ? 21 : 30;
+            ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT), -1, 0);
+        }
+#endif
+        if (ptr == MAP_FAILED) {
+            ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+#if defined(MADV_HUGEPAGE)
+            if (options_.page_kind != PageKind::REGULAR) {
+                madvise(ptr, length, MADV_HUGEPAGE);
+            }
+#endif
+        }
+        BindToNodes(ptr, length);
+        return ptr;
+    }
+
+    // Размещение по узлам задаётся до первого касания страниц, иначе оно не подействует
+    void BindToNodes(void* ptr, size_t length) const noexcept {
+#if defined(SYS_mbind)
+        if (options_.numa_policy == NumaPolicy::LOCAL || options_.node_mask == 0) {
+            return;
+        }
+        const int mode = options_.numa_policy == NumaPolicy::BIND ? MPOL_BIND : MPOL_INTERLEAVE;
+        const unsigned long node_mask = static_cast<unsigned long>(options_.node_mask);
+        syscall(SYS_mbind, ptr, length, mode, &node_mask, sizeof(node_mask) * 8, 0);
+#else
+        (void)ptr;
+        (void)length;
+#endif
+    }
+#endif
+
+    PageOptions options_;
+};
+
+// Аллокатор буферов, выровненных по Alignment байт: 64 исключает ложное разделение
+// строк кеша с соседними данными, 32 и 64 соответствуют регистрам AVX2 и AVX-512.
+// За последним элементом выделяется PaddingBytes обнулённых байт, так что SIMD-цикл
+// может прочитать полный регистр за концом буфера, не выходя за пределы блока
+template <typename T, size_t Alignment = 64, size_t PaddingBytes = Alignment>
+class AlignedAllocator {
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two");
+
+public:
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    static constexpr size_t ALIGNMENT = std::max(Alignment, alignof(T));
+    static constexpr size_t PADDING_BYTES = PaddingBytes;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment, PaddingBytes>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment, PaddingBytes>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n > (std::numeric_limits<size_t>::max() - PaddingBytes) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        const size_t bytes = n * sizeof(T);
+        void* ptr = ::operator new(bytes + PaddingBytes, std::align_val_t{ALIGNMENT});
+        std::memset(static_cast<unsigned char*>(ptr) + bytes, 0, PaddingBytes);
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t /*n*/) noexcept {
+        ::operator delete(ptr, std::align_val_t{ALIGNMENT});
+    }
+
+    friend bool operator==(const AlignedAllocator& /*lhs*/, const AlignedAllocator& /*rhs*/) noexcept {
+        return true;
+    }
+
+    friend bool operator!=(const AlignedAllocator& /*lhs*/, const AlignedAllocator& /*rhs*/) noexcept {
+        return false;
+    }
+};
+
+// Вектор с буфером, выровненным по Alignment байт
+template <typename T, size_t Alignment = 64>
+using AlignedVector = Vector<T, AlignedAllocator<T, Alignment>>;
@@ -0,0 +1,631 @@
+// Набор бенчмарков Vector в сравнении с std::vector.
+// Сборка: g++ -std=c++17 -O2 -DNDEBUG benchmark.cpp -o benchmark
+// Запуск: ./benchmark [--max-size N] [--max-bytes N] [--filter подстрока] [--csv]
+//
+// Для каждой операции выводятся время на элемент, число выделений памяти и промахов
+// кеша (на Linux через perf_event_open, если он доступен) на один прогон операции
+#include "vector.h"
+#include "vector_algorithms.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<size_t> num_allocations{0};
+
+}  // namespace
+
+#if defined(__GNUC__)
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#define BENCHMARK_NOINLINE
+#endif
+
+// Глобальные операторы new подсчитывают выделения памяти во всей программе.
+// Операторы не встраиваются, чтобы компилятор не сопоставлял malloc и free с new и delete
+BENCHMARK_NOINLINE void* operator new(size_t size) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+BENCHMARK_NOINLINE void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+BENCHMARK_NOINLINE void operator delete(void* ptr, size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+template <typename T>
+void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Счётчик промахов кеша последнего уровня для текущего потока
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter() {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    bool IsAvailable() const noexcept {
+        return fd_ >= 0;
+    }
+
+    void Start() noexcept {
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t Stop() noexcept {
+        uint64_t value = 0;
+#if defined(__linux__)
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+                value = 0;
+            }
+        }
+#endif
+        return value;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+struct Options {
+    size_t max_size = 1'000'000;
+    size_t max_bytes = size_t{1} << 30;
+    std::string filter;
+    bool csv = false;
+};
+
+struct Measurement {
+    double ns_per_element = 0;
+    double allocations_per_run = 0;
+    double cache_misses_per_run = -1;
+};
+
+// Количество прогонов в одной серии: чем меньше вектор, тем больше прогонов,
+// чтобы накладные расходы на замер времени не искажали результат
+size_t RunsPerBatch(size_t size) {
+    return std::clamp<size_t>(1'000'000 / std::max<size_t>(size, 1), 1, 1000);
+}
+
+// Измеряет run(state) на заранее подготовленных setup() состояниях. Подготовка и разрушение
+// состояний в замер не входят. Берётся лучшая из нескольких серий
+template <typename Setup, typename Run>
+Measurement Measure(size_t elements_per_run, size_t size, Setup setup, Run run) {
+    static CacheMissCounter cache_misses;
+    const size_t runs = RunsPerBatch(size);
+    const int batches = 5;
+    Measurement best;
+    best.ns_per_element = 1e300;
+    for (int batch = 0; batch < batches; ++batch) {
+        std::vector<decltype(setup())> states;
+        states.reserve(runs);
+        for (size_t i = 0; i < runs; ++i) {
+            states.push_back(setup());
+        }
+        const size_t allocations_before = num_allocations.load(std::memory_order_relaxed);
+        cache_misses.Start();
+        const auto start = std::chrono::steady_clock::now();
+        for (auto& state : states) {
+            run(state);
+            DoNotOptimize(state);
+        }
+        const auto finish = std::chrono::steady_clock::now();
+        const uint64_t misses = cache_misses.Stop();
+        const size_t allocations = num_allocations.load(std::memory_order_relaxed) - allocations_before;
+
+        const double ns = std::chrono::duration<double, std::nano>(finish - start).count();
+        const double ns_per_element = ns / static_cast<double>(runs * std::max<size_t>(elements_per_run, 1));
+        if (ns_per_element < best.ns_per_element) {
+            best.ns_per_element = ns_per_element;
+            best.allocations_per_run = static_cast<double>(allocations) / static_cast<double>(runs);
+            best.cache_misses_per_run =
+                cache_misses.IsAvailable() ? static_cast<double>(misses) / static_cast<double>(runs) : -1;
+        }
+    }
+    return best;
+}
+
+// Типы элементов
+
+struct Pod64 {
+    std::array<uint64_t, 8> data;
+};
+
+using MoveOnly = std::unique_ptr<int>;
+
+template <typename T>
+struct ElementTraits;
+
+template <>
+struct ElementTraits<int> {
+    static constexpr std::string_view NAME = "int";
+
+    static int Make(size_t i) {
+        return static_cast<int>(i);
+    }
+
+    template <typename EmplaceFn>
+    static void Emplace(EmplaceFn&& emplace, size_t i) {
+        emplace(static_cast<int>(i));
+    }
+
+    static uint64_t Touch(int value) {
+        return static_cast<uint64_t>(value);
+    }
+};
+
+template <>
+struct ElementTraits<Pod64> {
+    static constexpr std::string_view NAME = "pod64";
+
+    static Pod64 Make(size_t i) {
+        Pod64 pod{};
+        pod.data[0] = i;
+        return pod;
+    }
+
+    template <typename EmplaceFn>
+    static void Emplace(EmplaceFn&& emplace, size_t /*i*/) {
+        emplace();
+    }
+
+    static uint64_t Touch(const Pod64& value) {
+        return value.data[0];
+    }
+};
+
+template <>
+struct ElementTraits<std::string> {
+    static constexpr std::string_view NAME = "string";
+
+    static std::string Make(size_t i) {
+        // Строки длиннее буфера малых строк, чтобы каждая владела динамической памятью
+        std::string result(24, 'x');
+        result[0] = static_cast<char>('a' + i % 26);
+        return result;
+    }
+
+    template <typename EmplaceFn>
+    static void Emplace(EmplaceFn&& emplace, size_t /*i*/) {
+        emplace(size_t{24}, 'x');
+    }
+
+    static uint64_t Touch(const std::string& value) {
+        return static_cast<unsigned char>(value[0]);
+    }
+};
+
+template <>
+struct ElementTraits<MoveOnly> {
+    static constexpr std::string_view NAME = "move-only";
+
+    static MoveOnly Make(size_t i) {
+        return std::make_unique<int>(static_cast<int>(i));
+    }
+
+    template <typename EmplaceFn>
+    static void Emplace(EmplaceFn&& emplace, size_t i) {
+        emplace(new int(static_cast<int>(i)));
+    }
+
+    static uint64_t Touch(const MoveOnly& value) {
+        return static_cast<uint64_t>(*value);
+    }
+};
+
+// Единый интерфейс к сравниваемым контейнерам
+
+template <typename T>
+struct StdVectorFamily {
+    using Container = std::vector<T>;
+    static constexpr std::string_view NAME = "std::vector";
+
+    static void PushBack(Container& c, T&& value) {
+        c.push_back(std::move(value));
+    }
+
+    static void EmplaceBack(Container& c, size_t i) {
+        ElementTraits<T>::Emplace([&c](auto&&... args) {
+            c.emplace_back(std::forward<decltype(args)>(args)...);
+        }, i);
+    }
+
+    static void Reserve(Container& c, size_t n) {
+        c.reserve(n);
+    }
+
+    static void InsertMiddle(Container& c, T&& value) {
+        c.insert(c.begin() + c.size() / 2, std::move(value));
+    }
+
+    static void EraseMiddle(Container& c) {
+        c.erase(c.begin() + c.size() / 2);
+    }
+};
+
+// Название Vector с политикой проверок Checks
+template <typename Checks>
+constexpr std::string_view CheckedVectorName() {
+    if constexpr (std::is_same_v<Checks, BoundsVectorChecks>) {
+        return "BoundsVector";
+    } else if constexpr (std::is_same_v<Checks, DebugVectorChecks>) {
+        return "DebugVector";
+    } else {
+        return "Vector";
+    }
+}
+
+template <typename T, typename Checks = NoVectorChecks>
+struct VectorFamily {
+    using Container = Vector<T, std::allocator<T>, DoublingGrowth, NoVectorStats, Checks>;
+    static constexpr std::string_view NAME = CheckedVectorName<Checks>();
+
+    static void PushBack(Container& c, T&& value) {
+        c.PushBack(std::move(value));
+    }
+
+    static void EmplaceBack(Container& c, size_t i) {
+        ElementTraits<T>::Emplace([&c](auto&&... args) {
+            c.EmplaceBack(std::forward<decltype(args)>(args)...);
+        }, i);
+    }
+
+    static void Reserve(Container& c, size_t n) {
+        c.Reserve(n);
+    }
+
+    static void InsertMiddle(Container& c, T&& value) {
+        c.Insert(c.begin() + c.Size() / 2, std::move(value));
+    }
+
+    static void EraseMiddle(Container& c) {
+        c.Erase(c.begin() + c.Size() / 2);
+    }
+};
+
+template <typename Family, typename T>
+typename Family::Container MakeFilled(size_t size) {
+    typename Family::Container c;
+    Family::Reserve(c, size);
+    for (size_t i = 0; i < size; ++i) {
+        Family::PushBack(c, ElementTraits<T>::Make(i));
+    }
+    return c;
+}
+
+void PrintHeader(const Options& options) {
+    if (options.csv) {
+        std::cout << "container,operation,type,size,ns_per_element,allocations,cache_misses\n";
+    } else {
+        std::printf("%-12s %-14s %-10s %10s %14s %12s %14s\n", "container", "operation", "type", "size",
+                    "ns/element", "allocs/run", "misses/run");
+    }
+}
+
+void PrintRow(const Options& options, std::string_view container, std::string_view operation,
+              std::string_view type, size_t size, const Measurement& m) {
+    if (options.csv) {
+        std::cout << container << ',' << operation << ',' << type << ',' << size << ',' << m.ns_per_element << ','
+                  << m.allocations_per_run << ',' << m.cache_misses_per_run << '\n';
+    } else {
+        char misses[32] = "n/a";
+        if (m.cache_misses_per_run >= 0) {
+            std::snprintf(misses, sizeof(misses), "%.1f", m.cache_misses_per_run);
+        }
+        std::printf("%-12.*s %-14.*s %-10.*s %10zu %14.3f %12.1f %14s\n", static_cast<int>(container.size()),
+                    container.data(), static_cast<int>(operation.size()), operation.data(),
+                    static_cast<int>(type.size()), type.data(), size, m.ns_per_element, m.allocations_per_run,
+                    misses);
+    }
+}
+
+bool Matches(const Options& options, std::string_view name) {
+    return options.filter.empty() || name.find(options.filter) != std::string_view::npos;
+}
+
+template <typename Family, typename T>
+void RunSuite(const Options& options, size_t size) {
+    using Container = typename Family::Container;
+    using Traits = ElementTraits<T>;
+    const auto report = [&](std::string_view operation, auto&& measure) {
+        std::string name = std::string(Family::NAME) + '/' + std::string(operation) + '/' + std::string(Traits::NAME);
+        if (Matches(options, name)) {
+            PrintRow(options, Family::NAME, operation, Traits::NAME, size, measure());
+        }
+    };
+    // Вставка и удаление в середине квадратичны, поэтому их число ограничено
+    const size_t middle_ops = std::min<size_t>(size, 100);
+
+    report("PushBack", [&] {
+        return Measure(size, size, [] { return Container{}; }, [&](Container& c) {
+            for (size_t i = 0; i < size; ++i) {
+                Family::PushBack(c, Traits::Make(i));
+            }
+        });
+    });
+    report("EmplaceBack", [&] {
+        return Measure(size, size, [] { return Container{}; }, [&](Container& c) {
+            for (size_t i = 0; i < size; ++i) {
+                Family::EmplaceBack(c, i);
+            }
+        });
+    });
+    report("Reserve", [&] {
+        return Measure(size, size, [&] { return MakeFilled<Family, T>(size); }, [&](Container& c) {
+            Family::Reserve(c, size * 2);
+        });
+    });
+    report("InsertMiddle", [&] {
+        return Measure(middle_ops, size, [&] { return MakeFilled<Family, T>(size); }, [&](Container& c) {
+            for (size_t i = 0; i < middle_ops; ++i) {
+                Family::InsertMiddle(c, Traits::Make(i));
+            }
+        });
+    });
+    report("EraseMiddle", [&] {
+        return Measure(middle_ops, size, [&] { return MakeFilled<Family, T>(size); }, [&](Container& c) {
+            for (size_t i = 0; i < middle_ops; ++i) {
+                Family::EraseMiddle(c);
+            }
+        });
+    });
+    if constexpr (std::is_copy_constructible_v<T>) {
+        report("CopyAssign", [&] {
+            return Measure(size, size,
+                           [&] { return std::make_pair(MakeFilled<Family, T>(size), MakeFilled<Family, T>(size / 2)); },
+                           [](std::pair<Container, Container>& p) {
+                               p.second = p.first;
+                           });
+        });
+    }
+    report("MoveAssign", [&] {
+        return Measure(size, size,
+                       [&] { return std::make_pair(MakeFilled<Family, T>(size), MakeFilled<Family, T>(size / 2)); },
+                       [](std::pair<Container, Container>& p) {
+                           p.second = std::move(p.first);
+                       });
+    });
+    report("Iterate", [&] {
+        return Measure(size, size, [&] { return MakeFilled<Family, T>(size); }, [](Container& c) {
+            uint64_t sum = 0;
+            for (const T& value : c) {
+                sum += Traits::Touch(value);
+            }
+            DoNotOptimize(sum);
+        });
+    });
+    report("Index", [&] {
+        return Measure(size, size, [&] { return MakeFilled<Family, T>(size); }, [size](Container& c) {
+            uint64_t sum = 0;
+            for (size_t i = 0; i < size; ++i) {
+                sum += Traits::Touch(c[i]);
+            }
+            DoNotOptimize(sum);
+        });
+    });
+}
+
+template <typename T>
+void RunType(const Options& options) {
+    for (size_t size = 1; size <= options.max_size; size *= 10) {
+        if (size * sizeof(T) > options.max_bytes) {
+            break;
+        }
+        RunSuite<StdVectorFamily<T>, T>(options, size);
+        RunSuite<VectorFamily<T>, T>(options, size);
+        // Цена проверок границ и итераторов на тех же операциях
+        RunSuite<VectorFamily<T, BoundsVectorChecks>, T>(options, size);
+        RunSuite<VectorFamily<T, DebugVectorChecks>, T>(options, size);
+    }
+}
+
+// Алгоритмы vector_algorithms.h на каждом доступном наборе инструкций в сравнении
+// со стандартными алгоритмами на тех же данных
+
+template <typename T>
+constexpr std::string_view AlgorithmTypeName() {
+    if constexpr (std::is_same_v<T, int32_t>) {
+        return "int32";
+    } else if constexpr (std::is_same_v<T, float>) {
+        return "float";
+    } else {
+        return "double";
+    }
+}
+
+constexpr std::string_view SimdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::AVX512:
+            return "avx512";
+        case SimdLevel::NEON:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
+
+template <typename T>
+Vector<T> MakeAlgorithmInput(size_t size) {
+    Vector<T> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        v[i] = static_cast<T>(i % 1000);
+    }
+    return v;
+}
+
+template <typename T>
+void RunAlgorithmSuite(const Options& options, std::string_view container, size_t size, bool use_std) {
+    const std::string_view type = AlgorithmTypeName<T>();
+    const auto report = [&](std::string_view operation, auto&& measure) {
+        std::string name = std::string(container) + '/' + std::string(operation) + '/' + std::string(type);
+        if (Matches(options, name)) {
+            PrintRow(options, container, operation, type, size, measure());
+        }
+    };
+    const auto make = [size] { return MakeAlgorithmInput<T>(size); };
+    const auto make_pair = [size] { return std::make_pair(MakeAlgorithmInput<T>(size), MakeAlgorithmInput<T>(size)); };
+    // Искомого значения нет во входных данных, поэтому поиск просматривает их целиком
+    const T missing = static_cast<T>(-1);
+
+    report("Find", [&] {
+        return Measure(size, size, make, [&](Vector<T>& v) {
+            DoNotOptimize(use_std ? std::find(v.begin(), v.end(), missing) : Find(v, missing));
+        });
+    });
+    report("Count", [&] {
+        return Measure(size, size, make, [&](Vector<T>& v) {
+            DoNotOptimize(use_std ? static_cast<size_t>(std::count(v.begin(), v.end(), missing)) : Count(v, missing));
+        });
+    });
+    if (size != 0) {
+        report("MinMax", [&] {
+            return Measure(size, size, make, [&](Vector<T>& v) {
+                if (use_std) {
+                    const auto [min, max] = std::minmax_element(v.begin(), v.end());
+                    DoNotOptimize(*min);
+                    DoNotOptimize(*max);
+                } else {
+                    const auto [min, max] = MinMax(v);
+                    DoNotOptimize(min);
+                    DoNotOptimize(max);
+                }
+            });
+        });
+    }
+    report("Sum", [&] {
+        return Measure(size, size, make, [&](Vector<T>& v) {
+            DoNotOptimize(use_std ? std::accumulate(v.begin(), v.end(), SumResult<T>{}) : Sum(v));
+        });
+    });
+    report("Fill", [&] {
+        return Measure(size, size, make, [&](Vector<T>& v) {
+            if (use_std) {
+                std::fill(v.begin(), v.end(), missing);
+            } else {
+                Fill(v, missing);
+            }
+        });
+    });
+    report("Equal", [&] {
+        return Measure(size, size, make_pair, [&](std::pair<Vector<T>, Vector<T>>& p) {
+            const Vector<T>& lhs = p.first;
+            const Vector<T>& rhs = p.second;
+            DoNotOptimize(use_std ? std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()) : Equal(lhs, rhs));
+        });
+    });
+}
+
+template <typename T>
+void RunAlgorithms(const Options& options) {
+    const SimdLevel detected = GetSimdLevel();
+    for (size_t size = 1; size <= options.max_size; size *= 10) {
+        if (size * sizeof(T) > options.max_bytes) {
+            break;
+        }
+        RunAlgorithmSuite<T>(options, "std", size, true);
+        for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON}) {
+            if (SetSimdLevel(level)) {
+                RunAlgorithmSuite<T>(options, SimdLevelName(level), size, false);
+            }
+        }
+    }
+    SetSimdLevel(detected);
+}
+
+Options ParseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--max-size" && i + 1 < argc) {
+            options.max_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--max-bytes" && i + 1 < argc) {
+            options.max_bytes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-size N] [--max-bytes N] [--filter substring] [--csv]"
+                      << std::endl;
+            std::exit(1);
+        }
+    }
+    return options;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const Options options = ParseOptions(argc, argv);
+    PrintHeader(options);
+    RunType<int>(options);
+    RunType<Pod64>(options);
+    RunType<std::string>(options);
+    RunType<MoveOnly>(options);
+    RunAlgorithms<int32_t>(options);
+    RunAlgorithms<float>(options);
+    RunAlgorithms<double>(options);
+}
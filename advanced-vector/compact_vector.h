@@ -0,0 +1,435 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace compact_vector_detail {
+
+// Заголовок блока, предшествующий элементам
+struct Header {
+    uint32_t size;
+    uint32_t capacity;
+};
+
+template <typename T>
+inline constexpr size_t ALIGNMENT = std::max(alignof(T), alignof(Header));
+
+// Единица выделения памяти: по её границе выравниваются и заголовок, и элементы
+template <typename T>
+struct alignas(ALIGNMENT<T>) Unit {
+    unsigned char bytes[ALIGNMENT<T>];
+};
+
+template <typename T, typename Alloc>
+using UnitAllocator = typename std::allocator_traits<Alloc>::template rebind_alloc<Unit<T>>;
+
+}  // namespace compact_vector_detail
+
+// Вектор, объект которого состоит из одного указателя. Размер и ёмкость хранятся 32-битными
+// числами в заголовке перед элементами в том же блоке памяти, а пустой вектор, которому
+// ещё не понадобилась память, хранит nullptr и ничего не выделяет. Вектор вмещает
+// не более UINT32_MAX элементов, попытка превысить этот предел сообщается исключением
+// std::length_error. Аллокатор без состояния не увеличивает размер объекта.
+// Интерфейс и гарантии безопасности исключений совпадают с Vector
+template <typename T, typename Alloc = std::allocator<T>>
+class CompactVector : private compact_vector_detail::UnitAllocator<T, Alloc> {
+    using Header = compact_vector_detail::Header;
+    using Unit = compact_vector_detail::Unit<T>;
+    using UnitAlloc = compact_vector_detail::UnitAllocator<T, Alloc>;
+    using AllocTraits = std::allocator_traits<UnitAlloc>;
+
+    static constexpr size_t HEADER_UNITS = (sizeof(Header) + sizeof(Unit) - 1) / sizeof(Unit);
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr size_t MAX_SIZE = UINT32_MAX;
+
+    CompactVector() = default;
+
+    explicit CompactVector(const Alloc& alloc) noexcept : UnitAlloc(alloc) {
+    }
+
+    // Делегирование гарантирует, что при исключении из конструктора элемента деструктор освободит блок
+    explicit CompactVector(size_t size, const Alloc& alloc = Alloc()) : CompactVector(alloc) {
+        Resize(size);
+    }
+
+    CompactVector(const CompactVector& other)
+        : UnitAlloc(AllocTraits::select_on_container_copy_construction(other.Allocator())) {
+        CopyFrom(other);
+    }
+
+    CompactVector(CompactVector&& other) noexcept
+        : UnitAlloc(std::move(other.Allocator()))
+        , block_(std::exchange(other.block_, nullptr)) {
+    }
+
+    CompactVector& operator=(const CompactVector& rhs) {
+        if(this == &rhs) {
+            return *this;
+        }
+        if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+            if(Allocator() != rhs.Allocator()) {
+                // Память нужно освободить прежним аллокатором и выделить новым
+                CompactVector rhs_copy(rhs);
+                Release();
+                Allocator() = rhs.Allocator();
+                block_ = std::exchange(rhs_copy.block_, nullptr);
+                return *this;
+            }
+            Allocator() = rhs.Allocator();
+        }
+        if(rhs.Size() > Capacity()) {
+            CompactVector rhs_copy(rhs, Allocator());
+            std::swap(block_, rhs_copy.block_);
+        } else {
+            AssignElements(rhs.begin(), rhs.Size());
+        }
+        return *this;
+    }
+
+    CompactVector& operator=(CompactVector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                                           || AllocTraits::is_always_equal::value) {
+        if(this == &rhs) {
+            return *this;
+        }
+        if(CanStealBlock(rhs)) {
+            Release();
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                Allocator() = std::move(rhs.Allocator());
+            }
+            block_ = std::exchange(rhs.block_, nullptr);
+        } else {
+            // Чужой аллокатор не может освободить блок rhs, поэтому элементы перемещаются по одному
+            if(rhs.Size() > Capacity()) {
+                CompactVector new_vector(Allocator());
+                new_vector.Reserve(rhs.Size());
+                std::uninitialized_move_n(rhs.begin(), rhs.Size(), new_vector.begin());
+                new_vector.SetSize(rhs.Size());
+                std::swap(block_, new_vector.block_);
+            } else {
+                AssignElements(std::make_move_iterator(rhs.begin()), rhs.Size());
+            }
+            rhs.Clear();
+        }
+        return *this;
+    }
+
+    ~CompactVector() {
+        Release();
+    }
+
+    void Swap(CompactVector& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            std::swap(Allocator(), other.Allocator());
+        }
+        std::swap(block_, other.block_);
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return Alloc(Allocator());
+    }
+
+    void Reserve(size_t new_capacity) {
+        if(new_capacity > Capacity()) {
+            Reallocate(new_capacity);
+        }
+    }
+
+    // Освобождает неиспользуемую ёмкость. Память пустого вектора освобождается целиком
+    void ShrinkToFit() {
+        if(Size() == 0) {
+            Release();
+        } else if(Size() < Capacity()) {
+            Reallocate(Size());
+        }
+    }
+
+    void Resize(size_t new_size) {
+        if(new_size < Size()) {
+            DestroyN(begin() + new_size, Size() - new_size);
+            SetSize(new_size);
+        } else if(new_size > Size()) {
+            Reserve(new_size);
+            std::uninitialized_value_construct_n(end(), new_size - Size());
+            SetSize(new_size);
+        }
+    }
+
+    void Clear() noexcept {
+        if(block_ != nullptr) {
+            DestroyN(begin(), Size());
+            SetSize(0);
+        }
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        const size_t offset = pos - cbegin();
+        if(Size() == Capacity()) {
+            return ReallocationEmplace(offset, std::forward<Args>(args)...);
+        }
+        T* elem = offset == Size() ? new (end()) T(std::forward<Args>(args)...)
+                                   : ShiftAndEmplace(begin(), Size(), offset, std::forward<Args>(args)...);
+        SetSize(Size() + 1);
+        return elem;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return *Emplace(cend(), std::forward<Args>(args)...);
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        assert(Size() > 0);
+        DestroyN(end() - 1, 1);
+        SetSize(Size() - 1);
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    iterator Erase(const_iterator pos) noexcept {
+        return Erase(pos, pos + 1);
+    }
+
+    // Удаляет элементы [first, last), сдвигая хвост один раз
+    iterator Erase(const_iterator first, const_iterator last) noexcept {
+        const size_t offset = first - cbegin();
+        if(first != last) {
+            iterator new_end = MoveOrCopyAssign(const_cast<iterator>(last), end(), const_cast<iterator>(first));
+            DestroyN(new_end, end() - new_end);
+            SetSize(new_end - begin());
+        }
+        return begin() + offset;
+    }
+
+    size_t Size() const noexcept {
+        return block_ == nullptr ? 0 : HeaderOf(block_)->size;
+    }
+
+    size_t Capacity() const noexcept {
+        return block_ == nullptr ? 0 : HeaderOf(block_)->capacity;
+    }
+
+    bool Empty() const noexcept {
+        return Size() == 0;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < Size());
+        return begin()[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < Size());
+        return begin()[index];
+    }
+
+    iterator begin() noexcept {
+        return block_ == nullptr ? nullptr : ElementsOf(block_);
+    }
+
+    iterator end() noexcept {
+        return begin() + Size();
+    }
+
+    const_iterator begin() const noexcept {
+        return const_cast<CompactVector&>(*this).begin();
+    }
+
+    const_iterator end() const noexcept {
+        return begin() + Size();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+private:
+    CompactVector(const CompactVector& other, const UnitAlloc& alloc) : UnitAlloc(alloc) {
+        CopyFrom(other);
+    }
+
+    // Копирует элементы other в новый блок. Блок становится собственностью вектора только
+    // после успешного копирования, поэтому его можно вызывать из конструктора
+    void CopyFrom(const CompactVector& other) {
+        assert(block_ == nullptr);
+        if(other.Size() != 0) {
+            Unit* block = Allocate(other.Size());
+            try {
+                std::uninitialized_copy_n(other.begin(), other.Size(), ElementsOf(block));
+            } catch (...) {
+                Deallocate(block);
+                throw;
+            }
+            HeaderOf(block)->size = static_cast<uint32_t>(other.Size());
+            block_ = block;
+        }
+    }
+
+    UnitAlloc& Allocator() noexcept {
+        return *this;
+    }
+
+    const UnitAlloc& Allocator() const noexcept {
+        return *this;
+    }
+
+    static Header* HeaderOf(Unit* block) noexcept {
+        return std::launder(reinterpret_cast<Header*>(block));
+    }
+
+    static T* ElementsOf(Unit* block) noexcept {
+        return reinterpret_cast<T*>(block + HEADER_UNITS);
+    }
+
+    static size_t UnitsFor(size_t capacity) noexcept {
+        return HEADER_UNITS + (capacity * sizeof(T) + sizeof(Unit) - 1) / sizeof(Unit);
+    }
+
+    static void CheckSize(size_t size) {
+        if(size > MAX_SIZE) {
+            throw std::length_error("CompactVector is too large");
+        }
+    }
+
+    bool CanStealBlock(const CompactVector& other) const noexcept {
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value
+                      || AllocTraits::is_always_equal::value) {
+            return true;
+        } else {
+            return Allocator() == other.Allocator();
+        }
+    }
+
+    // Блок ёмкостью capacity с пустым заголовком
+    Unit* Allocate(size_t capacity) {
+        CheckSize(capacity);
+        Unit* block = AllocTraits::allocate(Allocator(), UnitsFor(capacity));
+        new (block) Header{0, static_cast<uint32_t>(capacity)};
+        return block;
+    }
+
+    void Deallocate(Unit* block) noexcept {
+        AllocTraits::deallocate(Allocator(), block, UnitsFor(HeaderOf(block)->capacity));
+    }
+
+    // Разрушает элементы и освобождает блок
+    void Release() noexcept {
+        if(block_ != nullptr) {
+            DestroyN(begin(), Size());
+            Deallocate(std::exchange(block_, nullptr));
+        }
+    }
+
+    void SetSize(size_t size) noexcept {
+        assert(block_ != nullptr || size == 0);
+        if(block_ != nullptr) {
+            HeaderOf(block_)->size = static_cast<uint32_t>(size);
+        }
+    }
+
+    size_t NextCapacity() const {
+        CheckSize(Size() + 1);
+        return std::min(DoublingGrowth::NextCapacity(Capacity(), Size() + 1, sizeof(T)), MAX_SIZE);
+    }
+
+    // Переносит элементы в новый блок ёмкостью new_capacity
+    void Reallocate(size_t new_capacity) {
+        Unit* new_block = Allocate(new_capacity);
+        const size_t size = Size();
+        try {
+            UninitializedTransferN(begin(), size, ElementsOf(new_block));
+        } catch (...) {
+            Deallocate(new_block);
+            throw;
+        }
+        HeaderOf(new_block)->size = static_cast<uint32_t>(size);
+        if(block_ != nullptr) {
+            DestroyTransferredN(begin(), size);
+            Deallocate(block_);
+        }
+        block_ = new_block;
+    }
+
+    // Присваивает общие элементы и создаёт или разрушает остальные. Ёмкости должно хватать
+    template <typename It>
+    void AssignElements(It first, size_t count) {
+        const size_t size = Size();
+        if(count < size) {
+            std::copy_n(first, count, begin());
+            DestroyN(begin() + count, size - count);
+        } else {
+            std::copy_n(first, size, begin());
+            std::uninitialized_copy_n(first + size, count - size, end());
+        }
+        SetSize(count);
+    }
+
+    template <typename... Args>
+    iterator ReallocationEmplace(size_t offset, Args&&... args) {
+        const size_t size = Size();
+        Unit* new_block = Allocate(NextCapacity());
+        T* new_data = ElementsOf(new_block);
+        T* elem;
+        try {
+            elem = new (new_data + offset) T(std::forward<Args>(args)...);
+        } catch (...) {
+            Deallocate(new_block);
+            throw;
+        }
+        try {
+            UninitializedTransferN(begin(), offset, new_data);
+        } catch (...) {
+            elem->~T();
+            Deallocate(new_block);
+            throw;
+        }
+        try {
+            UninitializedTransferN(begin() + offset, size - offset, new_data + offset + 1);
+        } catch (...) {
+            DestroyN(new_data, offset + 1);
+            Deallocate(new_block);
+            throw;
+        }
+        HeaderOf(new_block)->size = static_cast<uint32_t>(size + 1);
+        if(block_ != nullptr) {
+            DestroyTransferredN(begin(), size);
+            Deallocate(block_);
+        }
+        block_ = new_block;
+        return elem;
+    }
+
+    Unit* block_ = nullptr;
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include "vector.h"
+#include "segment_layout.h"
+
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// Вектор с конкурентным добавлением элементов в конец. Элементы хранятся в сегментах
+// RawMemory, размеры которых растут вдвое: сегмент k вмещает FIRST_SEGMENT_SIZE << k
+// элементов. При росте элементы не переезжают, поэтому ссылки на них остаются
+// действительными до Clear или Freeze.
+// EmplaceBack и чтение опубликованных элементов можно вызывать из разных потоков
+// одновременно без блокировок. Clear, Freeze и разрушение требуют, чтобы никакой другой
+// поток в это время не обращался к вектору
+template <typename T, typename Alloc = std::allocator<T>>
+class ConcurrentVector {
+    using Layout = GeometricSegmentLayout<32>;
+    using Location = typename Layout::Location;
+
+public:
+    using allocator_type = Alloc;
+
+    static constexpr size_t FIRST_SEGMENT_SIZE = Layout::FIRST_SEGMENT_SIZE;
+    static constexpr size_t MAX_SEGMENTS = Layout::MAX_SEGMENTS;
+
+    ConcurrentVector() = default;
+
+    explicit ConcurrentVector(const Alloc& alloc) noexcept : alloc_(alloc) {
+    }
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    ~ConcurrentVector() {
+        Clear();
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    // Создаёт элемент и возвращает его номер, который не меняется до Clear или Freeze.
+    // Элемент становится виден другим потокам через IsPublished после завершения
+    // конструктора. Если конструктор выбросил исключение, номер остаётся занятым,
+    // но элемент под ним никогда не будет опубликован
+    template <typename... Args>
+    size_t EmplaceBack(Args&&... args) {
+        const size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+        const Location location = Layout::Locate(index);
+        Segment& segment = AcquireSegment(location.segment);
+        new (segment.elements + location.offset) T(std::forward<Args>(args)...);
+        segment.published[location.offset].store(true, std::memory_order_release);
+        return index;
+    }
+
+    size_t PushBack(const T& value) {
+        return EmplaceBack(value);
+    }
+
+    size_t PushBack(T&& value) {
+        return EmplaceBack(std::move(value));
+    }
+
+    // Количество выданных номеров. Элементы с номерами меньше Size() могут быть ещё
+    // не созданы, их готовность проверяет IsPublished
+    size_t Size() const noexcept {
+        return std::min(size_.load(std::memory_order_acquire), Layout::MaxSize());
+    }
+
+    // Возвращает true, если элемент с номером index создан и его можно читать
+    bool IsPublished(size_t index) const noexcept {
+        if(index >= Size()) {
+            return false;
+        }
+        const Location location = Layout::Locate(index);
+        const Segment* segment = segments_[location.segment].load(std::memory_order_acquire);
+        return segment != nullptr && segment->published[location.offset].load(std::memory_order_acquire);
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(IsPublished(index));
+        const Location location = Layout::Locate(index);
+        return segments_[location.segment].load(std::memory_order_acquire)->elements[location.offset];
+    }
+
+    // Переносит опубликованные элементы в непрерывный Vector в порядке номеров
+    // и очищает этот вектор. Если перенос элемента выбросил исключение, этот вектор
+    // остаётся без изменений
+    Vector<T, Alloc> Freeze() {
+        Vector<T, Alloc> result(alloc_);
+        const size_t size = Size();
+        result.Reserve(size);
+        for(size_t index = 0; index < size; ++index) {
+            if(IsPublished(index)) {
+                result.EmplaceBack(std::move_if_noexcept((*this)[index]));
+            }
+        }
+        Clear();
+        return result;
+    }
+
+    // Разрушает опубликованные элементы и освобождает сегменты
+    void Clear() noexcept {
+        const size_t size = Size();
+        for(size_t k = 0; k < MAX_SEGMENTS; ++k) {
+            Segment* segment = segments_[k].exchange(nullptr, std::memory_order_acquire);
+            if(segment == nullptr) {
+                continue;
+            }
+            const size_t first = Layout::SegmentStart(k);
+            const size_t count = first < size ? std::min(Layout::SegmentSize(k), size - first) : 0;
+            for(size_t offset = 0; offset < count; ++offset) {
+                if(segment->published[offset].load(std::memory_order_relaxed)) {
+                    DestroyN(segment->elements + offset, 1);
+                }
+            }
+            delete segment;
+        }
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct Segment {
+        Segment(size_t size, const Alloc& alloc)
+            : elements(size, alloc)
+            , published(new std::atomic<bool>[size]()) {
+        }
+
+        RawMemory<T, Alloc> elements;
+        std::unique_ptr<std::atomic<bool>[]> published;
+    };
+
+    // Возвращает сегмент k, создавая его при первом обращении. Если несколько потоков
+    // создали сегмент одновременно, остаётся сегмент первого из них
+    Segment& AcquireSegment(size_t k) {
+        if(k >= MAX_SEGMENTS) {
+            throw std::length_error("ConcurrentVector is too large");
+        }
+        Segment* segment = segments_[k].load(std::memory_order_acquire);
+        if(segment != nullptr) {
+            return *segment;
+        }
+        auto new_segment = std::make_unique<Segment>(Layout::SegmentSize(k), alloc_);
+        if(segments_[k].compare_exchange_strong(segment, new_segment.get(), std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+            return *new_segment.release();
+        }
+        return *segment;
+    }
+
+    Alloc alloc_;
+    std::atomic<Segment*> segments_[MAX_SEGMENTS] = {};
+    std::atomic<size_t> size_{0};
+};
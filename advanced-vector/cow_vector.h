@@ -0,0 +1,259 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+template <typename T, typename Alloc>
+class AtomicCowVector;
+
+// Вектор с копированием при записи. Копии разделяют один буфер со счётчиком ссылок,
+// поэтому копирование выполняется за O(1) без выделения памяти. Изменение через Edit
+// и другие изменяющие методы сначала копирует элементы, если буфер разделён с другими
+// копиями, и с этого момента копия владеет собственным буфером.
+// Разные объекты CowVector можно читать и изменять из разных потоков, даже если они разделяют
+// буфер. Один объект, как и Vector, нельзя изменять одновременно с другими обращениями к нему
+template <typename T, typename Alloc = std::allocator<T>>
+class CowVector {
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using const_iterator = const T*;
+    using vector_type = Vector<T, Alloc>;
+
+    CowVector() = default;
+
+    // Буфер пустого вектора не выделяется
+    explicit CowVector(vector_type elements)
+        : shared_(elements.Size() == 0 && elements.Capacity() == 0 ? nullptr : new Shared(std::move(elements))) {
+    }
+
+    CowVector(const CowVector& other) noexcept : shared_(other.shared_) {
+        if(shared_ != nullptr) {
+            shared_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    CowVector(CowVector&& other) noexcept : shared_(std::exchange(other.shared_, nullptr)) {
+    }
+
+    CowVector& operator=(const CowVector& rhs) noexcept {
+        CowVector rhs_copy(rhs);
+        Swap(rhs_copy);
+        return *this;
+    }
+
+    CowVector& operator=(CowVector&& rhs) noexcept {
+        if(this != &rhs) {
+            CowVector old(std::move(*this));
+            Swap(rhs);
+        }
+        return *this;
+    }
+
+    ~CowVector() {
+        Release(shared_);
+    }
+
+    void Swap(CowVector& other) noexcept {
+        std::swap(shared_, other.shared_);
+    }
+
+    size_t Size() const noexcept {
+        return shared_ == nullptr ? 0 : shared_->elements.Size();
+    }
+
+    bool Empty() const noexcept {
+        return Size() == 0;
+    }
+
+    // Количество копий, разделяющих буфер, включая опубликованные в AtomicCowVector
+    size_t UseCount() const noexcept {
+        return shared_ == nullptr ? 0 : shared_->refs.load(std::memory_order_relaxed);
+    }
+
+    bool IsShared() const noexcept {
+        return shared_ != nullptr && shared_->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    const vector_type& View() const noexcept {
+        static const vector_type empty;
+        return shared_ == nullptr ? empty : shared_->elements;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < Size());
+        return shared_->elements[index];
+    }
+
+    const_iterator begin() const noexcept {
+        return View().begin();
+    }
+
+    const_iterator end() const noexcept {
+        return View().end();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    // Возвращает элементы для изменения, предварительно скопировав их, если буфер разделён.
+    // Ссылка действительна до следующего копирования этого объекта
+    vector_type& Edit() {
+        if(shared_ == nullptr) {
+            shared_ = new Shared(vector_type());
+        } else if(IsShared()) {
+            Shared* copy = new Shared(shared_->elements);
+            Release(shared_);
+            shared_ = copy;
+        }
+        return shared_->elements;
+    }
+
+    void Set(size_t index, T value) {
+        assert(index < Size());
+        Edit()[index] = std::move(value);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return Edit().EmplaceBack(std::forward<Args>(args)...);
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() {
+        Edit().PopBack();
+    }
+
+    void Resize(size_t new_size) {
+        Edit().Resize(new_size);
+    }
+
+    // Отказывается от разделённого буфера, не копируя его элементы
+    void Clear() noexcept {
+        if(IsShared()) {
+            Release(std::exchange(shared_, nullptr));
+        } else if(shared_ != nullptr) {
+            shared_->elements.Clear();
+        }
+    }
+
+private:
+    friend class AtomicCowVector<T, Alloc>;
+
+    struct Shared {
+        explicit Shared(vector_type elements) : elements(std::move(elements)) {
+        }
+
+        std::atomic<size_t> refs{1};
+        vector_type elements;
+    };
+
+    // Принимает уже учтённую в счётчике ссылку на shared
+    explicit CowVector(Shared* shared) noexcept : shared_(shared) {
+    }
+
+    static void Release(Shared* shared) noexcept {
+        if(shared != nullptr && shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete shared;
+        }
+    }
+
+    Shared* shared_ = nullptr;
+};
+
+// Ячейка, через которую один поток публикует новые версии CowVector, а множество читателей
+// получают текущую версию. Publish и Acquire выполняются за O(1), не копируют элементы
+// и не блокируются: читатели, получившие версию, продолжают пользоваться ею после
+// публикации следующей, а последняя копия версии освобождает её буфер.
+// Слово ячейки хранит указатель на буфер в младших 48 битах, а в старших — число читателей,
+// которые уже прочитали указатель, но ещё не увеличили счётчик ссылок буфера. Публикация
+// переносит это число в счётчик заменяемого буфера, поэтому тот не будет освобождён, пока
+// такие читатели не закончат. Одновременно получать версию могут не более 65535 потоков
+template <typename T, typename Alloc = std::allocator<T>>
+class AtomicCowVector {
+    using Cow = CowVector<T, Alloc>;
+    using Shared = typename Cow::Shared;
+
+    static_assert(sizeof(void*) == sizeof(uint64_t), "AtomicCowVector packs pointers into 64-bit words");
+
+    static constexpr uint64_t ONE_BORROW = uint64_t{1} << 48;
+    static constexpr uint64_t POINTER_MASK = ONE_BORROW - 1;
+
+public:
+    AtomicCowVector() = default;
+
+    explicit AtomicCowVector(Cow value) noexcept {
+        Publish(std::move(value));
+    }
+
+    AtomicCowVector(const AtomicCowVector&) = delete;
+    AtomicCowVector& operator=(const AtomicCowVector&) = delete;
+
+    ~AtomicCowVector() {
+        ReleaseWord(word_.load(std::memory_order_acquire));
+    }
+
+    // Делает value текущей версией. Изменения value, сделанные до публикации, видны
+    // читателям, получившим её
+    void Publish(Cow value) noexcept {
+        Shared* shared = std::exchange(value.shared_, nullptr);
+        const auto address = reinterpret_cast<uintptr_t>(shared);
+        assert((address & ~POINTER_MASK) == 0);
+        ReleaseWord(word_.exchange(address, std::memory_order_acq_rel));
+    }
+
+    // Текущая версия. Копия разделяет буфер с опубликованной
+    Cow Acquire() const noexcept {
+        uint64_t word = word_.fetch_add(ONE_BORROW, std::memory_order_acquire) + ONE_BORROW;
+        Shared* shared = PointerOf(word);
+        if(shared != nullptr) {
+            shared->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Возвращаем заимствование ячейке, если она всё ещё хранит тот же буфер. Иначе
+        // публикация уже перенесла его в счётчик буфера, и его нужно снять оттуда
+        while(PointerOf(word) == shared && (word & ~POINTER_MASK) != 0) {
+            if(word_.compare_exchange_weak(word, word - ONE_BORROW, std::memory_order_relaxed)) {
+                return Cow(shared);
+            }
+        }
+        if(shared != nullptr) {
+            shared->refs.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return Cow(shared);
+    }
+
+private:
+    static Shared* PointerOf(uint64_t word) noexcept {
+        return reinterpret_cast<Shared*>(static_cast<uintptr_t>(word & POINTER_MASK));
+    }
+
+    // Освобождает ссылку, которой владела ячейка, передав буферу незавершённые заимствования
+    static void ReleaseWord(uint64_t word) noexcept {
+        Shared* shared = PointerOf(word);
+        if(shared == nullptr) {
+            return;
+        }
+        if(const uint64_t borrows = word >> 48; borrows != 0) {
+            shared->refs.fetch_add(borrows, std::memory_order_relaxed);
+        }
+        Cow::Release(shared);
+    }
+
+    mutable std::atomic<uint64_t> word_{0};
+};
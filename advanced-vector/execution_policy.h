@@ -0,0 +1,15 @@
+#pragma once
+#include "vector.h"
+
+#include <execution>
+
+// Разрешает передавать стандартные политики исполнения в параллельные перегрузки Vector:
+// Vector<T> copy(std::execution::par, other). Заголовок подключается отдельно, так как
+// <execution> в libstdc++ требует компоновки с TBB
+template <>
+struct is_parallel_policy<std::execution::parallel_policy> : std::true_type {
+};
+
+template <>
+struct is_parallel_policy<std::execution::parallel_unsequenced_policy> : std::true_type {
+};
@@ -1,10 +1,40 @@
 #include "vector.h"
+#include "allocators.h"
+#include "small_vector.h"
+#include "vector_stats.h"
+#include "concurrent_vector.h"
+#include "cow_vector.h"
+#include "segmented_vector.h"
+#include "mapped_vector.h"
+#include "serialization.h"
+#include "soa_vector.h"
+#include "persistent_vector.h"
+#include "static_vector.h"
+#include "compact_vector.h"
+#include "vector_io.h"
+#include "vector_algorithms.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 namespace {
 
 // "Магическое" число, используемое для отслеживания живости объекта
@@ -81,6 +111,7 @@ struct Obj {
 
     ~Obj() {
         ++num_destroyed;
+        destroyed_id_sum += id;
         id = 0;
     }
 
@@ -95,6 +126,7 @@ struct Obj {
         num_copied = 0;
         num_moved = 0;
         num_destroyed = 0;
+        destroyed_id_sum = 0;
         num_constructed_with_id = 0;
         num_constructed_with_id_and_name = 0;
         num_assigned = 0;
@@ -112,10 +144,142 @@ struct Obj {
     static inline int num_copied = 0;
     static inline int num_moved = 0;
     static inline int num_destroyed = 0;
+    static inline int destroyed_id_sum = 0;
     static inline int num_assigned = 0;
     static inline int num_move_assigned = 0;
 };
 
+// Аллокатор с состоянием, подсчитывающий выделения памяти через общий счётчик
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit CountingAllocator(int id = 0) noexcept
+        : id(id) {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept
+        : id(other.id) {
+    }
+
+    T* allocate(size_t n) {
+        ++num_allocations;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        ++num_deallocations;
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    friend bool operator==(const CountingAllocator& lhs, const CountingAllocator& rhs) noexcept {
+        return lhs.id == rhs.id;
+    }
+
+    friend bool operator!=(const CountingAllocator& lhs, const CountingAllocator& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    static void ResetCounters() {
+        num_allocations = 0;
+        num_deallocations = 0;
+    }
+
+    int id = 0;
+
+    static inline int num_allocations = 0;
+    static inline int num_deallocations = 0;
+};
+
+// Тип, заявивший о тривиальной перемещаемости. Если вектор переносит его побайтово,
+// ни конструкторы перемещения, ни деструкторы при росте не вызываются
+struct RelocatableObj {
+    explicit RelocatableObj(int id)
+        : id(id)  //
+    {
+    }
+
+    RelocatableObj(RelocatableObj&& other) noexcept
+        : id(other.id)  //
+    {
+        ++num_moved;
+    }
+
+    RelocatableObj(const RelocatableObj& other)
+        : id(other.id)  //
+    {
+        ++num_copied;
+    }
+
+    RelocatableObj& operator=(RelocatableObj&& other) noexcept {
+        id = other.id;
+        return *this;
+    }
+
+    ~RelocatableObj() {
+        ++num_destroyed;
+    }
+
+    int id = 0;
+
+    static inline int num_moved = 0;
+    static inline int num_copied = 0;
+    static inline int num_destroyed = 0;
+};
+
+}  // namespace
+
+template <>
+struct is_trivially_relocatable<RelocatableObj> : std::true_type {
+};
+
+namespace {
+
+// Тип со счётчиками, безопасными для многопоточного создания. Копирование объекта
+// со значением POISON выбрасывает исключение
+struct AtomicObj {
+    static constexpr int POISON = -1;
+
+    AtomicObj() {
+        if(throw_on_default_construction.load()) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+    }
+
+    explicit AtomicObj(int value)
+        : value(value)  //
+    {
+        ++num_alive;
+    }
+
+    AtomicObj(const AtomicObj& other)
+        : value(other.value)  //
+    {
+        if(other.value == POISON) {
+            throw std::runtime_error("Oops");
+        }
+        ++num_alive;
+        ++num_copied;
+    }
+
+    AtomicObj& operator=(const AtomicObj& other) = default;
+
+    ~AtomicObj() {
+        --num_alive;
+    }
+
+    int value = 0;
+
+    static inline std::atomic<int> num_alive{0};
+    static inline std::atomic<int> num_copied{0};
+    static inline std::atomic<bool> throw_on_default_construction{false};
+};
+
 }  // namespace
 
 void Test1() {
@@ -537,8 +701,9 @@ void Test6() {
         assert(Obj::num_copied == 0);
         assert(Obj::num_default_constructed == SIZE);
         assert(Obj::num_constructed_with_id_and_name == 1);
+        // Элемент создаётся сразу на месте, без временного объекта и присваивания из него
         assert(Obj::num_moved == old_num_moved + 1);
-        assert(Obj::num_move_assigned == SIZE - 3);
+        assert(Obj::num_move_assigned == SIZE - 4);
         assert(Obj::num_assigned == 0);
     }
     {
@@ -558,85 +723,2327 @@ void Test6() {
     }
 }
 
-struct C {
-    C() noexcept {
-        ++def_ctor;
+void Test7() {
+    const size_t SIZE = 10;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        CountingAllocator<Obj>::ResetCounters();
+        {
+            Vector<Obj, CountingAllocator<Obj>> v(SIZE, CountingAllocator<Obj>(1));
+            v.PushBack(Obj{ID});
+            assert(v.GetAllocator().id == 1);
+            assert(CountingAllocator<Obj>::num_allocations == 2);
+            assert(CountingAllocator<Obj>::num_deallocations == 1);
+
+            const auto v_copy(v);
+            assert(v_copy.GetAllocator().id == 1);
+            assert(v_copy[SIZE].id == ID);
+
+            Vector<Obj, CountingAllocator<Obj>> v_other(CountingAllocator<Obj>(2));
+            v_other = v;
+            assert(v_other.GetAllocator().id == 1);
+            assert(v_other.Size() == SIZE + 1);
+
+            Vector<Obj, CountingAllocator<Obj>> v_moved(CountingAllocator<Obj>(3));
+            v_moved = std::move(v);
+            assert(v_moved.GetAllocator().id == 1);
+            assert(v_moved.Size() == SIZE + 1);
+
+            Vector<Obj, CountingAllocator<Obj>> v_swapped(1, CountingAllocator<Obj>(4));
+            v_swapped.Swap(v_moved);
+            assert(v_swapped.GetAllocator().id == 1);
+            assert(v_moved.GetAllocator().id == 4);
+            assert(v_swapped.Size() == SIZE + 1);
+        }
+        assert(CountingAllocator<Obj>::num_allocations == CountingAllocator<Obj>::num_deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
     }
-    C(const C& /*other*/) noexcept {
-        ++copy_ctor;
+    {
+        Obj::ResetCounters();
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::monotonic_buffer_resource other_arena;
+        {
+            Vector<Obj, std::pmr::polymorphic_allocator<Obj>> v(&arena);
+            for (int i = 0; i < static_cast<int>(SIZE); ++i) {
+                v.EmplaceBack(i);
+            }
+            assert(v.GetAllocator().resource() == &arena);
+
+            // Копия получает ресурс по умолчанию, а не ресурс оригинала
+            const auto v_copy(v);
+            assert(v_copy.GetAllocator().resource() == std::pmr::get_default_resource());
+
+            // Аллокаторы не распространяются, поэтому элементы перемещаются поэлементно
+            Vector<Obj, std::pmr::polymorphic_allocator<Obj>> v_other(&other_arena);
+            v_other = std::move(v);
+            assert(v_other.GetAllocator().resource() == &other_arena);
+            assert(v_other.Size() == SIZE);
+            assert(v_other[SIZE - 1].id == static_cast<int>(SIZE - 1));
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
     }
-    C(C&& /*other*/) noexcept {
-        ++move_ctor;
+}
+
+void Test8() {
+    const int SIZE = 1000;
+    {
+        Vector<int> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.PushBack(i);
+        }
+        v.Insert(v.begin() + SIZE / 2, -1);
+        v.Reserve(SIZE * 4);
+        assert(v.Size() == static_cast<size_t>(SIZE + 1));
+        assert(v[SIZE / 2] == -1);
+        assert(v[SIZE / 2 + 1] == SIZE / 2);
+        assert(v[SIZE] == SIZE - 1);
     }
-    C& operator=(const C& other) noexcept {
-        if (this != &other) {
-            ++copy_assign;
+    {
+        {
+            Vector<RelocatableObj> v;
+            for (int i = 0; i < SIZE; ++i) {
+                v.EmplaceBack(i);
+            }
+            v.Reserve(SIZE * 4);
+            assert(RelocatableObj::num_moved == 0);
+            assert(RelocatableObj::num_copied == 0);
+            assert(RelocatableObj::num_destroyed == 0);
+            for (int i = 0; i < SIZE; ++i) {
+                assert(v[i].id == i);
+            }
         }
-        return *this;
+        assert(RelocatableObj::num_destroyed == SIZE);
     }
-    C& operator=(C&& /*other*/) noexcept {
-        ++move_assign;
-        return *this;
+}
+
+void Test9() {
+    {
+        // Рост буфера переходит через порог отображения памяти и продолжается через mremap
+        const size_t SIZE = ReallocatingAllocator<int>::MAP_THRESHOLD;
+        Vector<int, ReallocatingAllocator<int>> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        v.Reserve(SIZE * 4);
+        assert(v.Capacity() == SIZE * 4);
+        assert(v.Size() == SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
     }
-    ~C() {
-        ++dtor;
+    {
+        const int SIZE = 100;
+        RelocatableObj::num_moved = 0;
+        RelocatableObj::num_destroyed = 0;
+        {
+            Vector<RelocatableObj, ReallocatingAllocator<RelocatableObj>> v;
+            v.Reserve(SIZE);
+            for (int i = 0; i < SIZE; ++i) {
+                v.EmplaceBack(i);
+            }
+            // Вставка копии собственного элемента при расширении буфера на месте должна быть безопасна
+            assert(v.Size() == v.Capacity());
+            auto* pos = v.Insert(v.begin() + 1, v[SIZE - 1]);
+            assert(pos == &v[1]);
+            assert(v[0].id == 0);
+            assert(v[1].id == SIZE - 1);
+            assert(v[2].id == 1);
+            assert(v[SIZE].id == SIZE - 1);
+            assert(RelocatableObj::num_moved == 0);
+            assert(RelocatableObj::num_destroyed == 0);
+        }
+        assert(RelocatableObj::num_destroyed == SIZE + 1);
     }
+}
 
-    static void Reset() {
-        def_ctor = 0;
-        copy_ctor = 0;
-        move_ctor = 0;
-        copy_assign = 0;
-        move_assign = 0;
-        dtor = 0;
+void Test10() {
+    static_assert(SizeClassGrowth<>::RoundUpToSizeClass(1) == 16);
+    static_assert(SizeClassGrowth<>::RoundUpToSizeClass(17) == 32);
+    static_assert(SizeClassGrowth<>::RoundUpToSizeClass(65) == 80);
+    static_assert(SizeClassGrowth<>::RoundUpToSizeClass(129) == 160);
+    static_assert(SizeClassGrowth<>::RoundUpToSizeClass(4097) == 5120);
+    {
+        Vector<int, std::allocator<int>, HalfGrowth> v;
+        size_t expected_capacities[] = {1, 2, 3, 4, 6, 9, 13, 19};
+        size_t step = 0;
+        for (int i = 0; i < 19; ++i) {
+            if (v.Size() == v.Capacity()) {
+                v.PushBack(i);
+                assert(v.Capacity() == expected_capacities[step++]);
+            } else {
+                v.PushBack(i);
+            }
+        }
+        assert(step == std::size(expected_capacities));
+    }
+    {
+        Vector<int, std::allocator<int>, GeometricGrowth<2, 1, 8>> v;
+        v.PushBack(1);
+        assert(v.Capacity() == 8);
+    }
+    {
+        Vector<int, std::allocator<int>, LinearAboveThresholdGrowth<64, 32>> v;
+        for (int i = 0; i < 40; ++i) {
+            v.PushBack(i);
+        }
+        // 1, 2, 4, 8, 16 элементов удвоением, затем шагами по 8 элементов (32 байта)
+        assert(v.Capacity() == 40);
+        v.PushBack(40);
+        assert(v.Capacity() == 48);
+    }
+    {
+        struct Triple {
+            int a = 0;
+            int b = 0;
+            int c = 0;
+        };
+        Vector<Triple, std::allocator<Triple>, SizeClassGrowth<>> v;
+        v.PushBack(Triple{});
+        // 12 байт округляются до 16, что вмещает только один элемент
+        assert(v.Capacity() == 1);
+        v.PushBack(Triple{});
+        // 24 байта округляются до 32
+        assert(v.Capacity() == 2);
+        v.PushBack(Triple{});
+        // 48 байт - ровно класс размера
+        assert(v.Capacity() == 4);
+        for (int i = 0; i < 2; ++i) {
+            v.PushBack(Triple{});
+        }
+        // 96 байт - класс размера
+        assert(v.Capacity() == 8);
     }
+}
 
-    inline static size_t def_ctor = 0;
-    inline static size_t copy_ctor = 0;
-    inline static size_t move_ctor = 0;
-    inline static size_t copy_assign = 0;
-    inline static size_t move_assign = 0;
-    inline static size_t dtor = 0;
-};
+void Test11() {
+    const size_t INLINE_SIZE = 4;
+    const int ID = 42;
+    using SmallObjVector = SmallVector<Obj, INLINE_SIZE, CountingAllocator<Obj>>;
+    {
+        Obj::ResetCounters();
+        CountingAllocator<Obj>::ResetCounters();
+        {
+            SmallObjVector v;
+            assert(v.Capacity() == INLINE_SIZE);
+            for (int i = 0; i < static_cast<int>(INLINE_SIZE) - 1; ++i) {
+                v.EmplaceBack(i);
+            }
+            v.Insert(v.begin() + 1, Obj{ID});
+            assert(v.Erase(v.begin() + 2)->id == 2);
+            v.PushBack(Obj{3});
+            assert(v.IsInline());
+            assert(v.Size() == INLINE_SIZE);
+            assert(v[1].id == ID);
+            assert(CountingAllocator<Obj>::num_allocations == 0);
+
+            SmallObjVector v_copy(v);
+            assert(v_copy.IsInline());
+            SmallObjVector v_moved(std::move(v_copy));
+            assert(v_moved.IsInline());
+            assert(v_moved.Size() == INLINE_SIZE);
+            assert(v_moved[1].id == ID);
+            assert(v_copy.Size() == 0);
+            assert(CountingAllocator<Obj>::num_allocations == 0);
 
-void Dump() {
-    using namespace std;
-    cerr << "Def ctors: "sv << C::def_ctor              //
-         << ", Copy ctors: "sv << C::copy_ctor          //
-         << ", Move ctors: "sv << C::move_ctor          //
-         << ", Copy assignments: "sv << C::copy_assign  //
-         << ", Move assignments: "sv << C::move_assign  //
-         << ", Dtors: "sv << C::dtor << endl;
+            // Переполнение переносит элементы в динамический буфер
+            Obj obj{ID + 1};
+            v.PushBack(obj);
+            assert(!v.IsInline());
+            assert(v.Size() == INLINE_SIZE + 1);
+            assert(v.Capacity() == INLINE_SIZE * 2);
+            assert(v[INLINE_SIZE].id == ID + 1);
+            assert(CountingAllocator<Obj>::num_allocations == 1);
+
+            // Динамический буфер при перемещении заимствуется
+            const Obj* data = &v[0];
+            SmallObjVector v_stolen(std::move(v));
+            assert(&v_stolen[0] == data);
+            assert(CountingAllocator<Obj>::num_allocations == 1);
+
+            v_moved.Swap(v_stolen);
+            assert(v_moved.Size() == INLINE_SIZE + 1);
+            assert(v_stolen.Size() == INLINE_SIZE);
+            assert(&v_moved[0] == data);
+
+            v_stolen = v_moved;
+            assert(v_stolen.Size() == INLINE_SIZE + 1);
+            assert(v_stolen[INLINE_SIZE].id == ID + 1);
+        }
+        assert(CountingAllocator<Obj>::num_allocations == CountingAllocator<Obj>::num_deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, INLINE_SIZE> v(INLINE_SIZE);
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.EmplaceBack();
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        // Строгая гарантия: вектор не изменился и остался во внутреннем буфере
+        assert(v.IsInline());
+        assert(v.Size() == INLINE_SIZE);
+        assert(Obj::GetAliveObjectCount() == INLINE_SIZE);
+    }
+    {
+        SmallVector<TestObj, 1> v(1);
+        v.PushBack(v[0]);
+        v.Insert(v.begin(), v[1]);
+        assert(std::all_of(v.begin(), v.end(), [](const TestObj& obj) {
+            return obj.IsAlive();
+        }));
+    }
 }
 
-void Benchmark() {
-    using namespace std;
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "std::vector:"sv << endl;
-            C::Reset();
-            vector<C> v(NUM);
-            Dump();
-            v.push_back(c);
+void Test12() {
+    const size_t SIZE = 10;
+    {
+        // Хвост длиннее вставляемого диапазона
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        std::vector<Obj> src;
+        for (int i = 1; i <= 3; ++i) {
+            src.emplace_back(i);
+        }
+        Obj::ResetCounters();
+        auto pos = v.Insert(v.cbegin() + 2, src.begin(), src.end());
+        assert(pos == &v[2]);
+        assert(v.Size() == SIZE + 3);
+        assert(v.Capacity() == SIZE * 2);
+        assert(v[1].id == 0 && v[2].id == 1 && v[3].id == 2 && v[4].id == 3 && v[5].id == 0);
+        assert(Obj::num_copied == 0);
+        assert(Obj::num_assigned == 3);
+        assert(Obj::num_moved == 3);
+        assert(Obj::num_move_assigned == static_cast<int>(SIZE - 2 - 3));
+    }
+    {
+        // Хвост короче вставляемого диапазона
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        std::vector<Obj> src(5, Obj{7});
+        Obj::ResetCounters();
+        v.Insert(v.cbegin() + SIZE - 2, src.begin(), src.end());
+        assert(v.Size() == SIZE + 5);
+        assert(v[SIZE - 3].id == 0);
+        for (size_t i = SIZE - 2; i < SIZE + 3; ++i) {
+            assert(v[i].id == 7);
         }
-        Dump();
-    } catch (...) {
+        assert(v[SIZE + 3].id == 0 && v[SIZE + 4].id == 0);
+        assert(Obj::num_copied == 3);
+        assert(Obj::num_assigned == 2);
+        assert(Obj::num_moved == 2);
     }
-    try {
-        const size_t NUM = 10;
-        C c;
+    {
+        // Одно перераспределение памяти при вставке с переполнением
+        Obj::ResetCounters();
+        CountingAllocator<Obj>::ResetCounters();
+        Vector<Obj, CountingAllocator<Obj>> v(SIZE);
+        std::vector<Obj> src(SIZE * 3);
+        Obj::ResetCounters();
+        v.Insert(v.cbegin() + 1, src.begin(), src.end());
+        assert(CountingAllocator<Obj>::num_allocations == 2);
+        assert(v.Capacity() == SIZE * 4);
+        assert(v.Size() == SIZE * 4);
+        assert(Obj::num_copied == static_cast<int>(SIZE * 3));
+        assert(Obj::num_moved == static_cast<int>(SIZE));
+    }
+    {
+        Vector<int> v;
+        const int values[] = {1, 2, 3, 4};
+        v.Append(values);
+        v.Insert(v.cbegin() + 1, 3, v[3]);
+        v.Insert(v.cbegin(), size_t{2}, -1);
+        const std::vector<int> expected{-1, -1, 1, 4, 4, 4, 2, 3, 4};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+
+        std::istringstream input("5 6 7");
+        v.Insert(v.cbegin() + 2, std::istream_iterator<int>(input), std::istream_iterator<int>());
+        assert(v.Size() == expected.size() + 3);
+        assert(v[1] == -1 && v[2] == 5 && v[3] == 6 && v[4] == 7 && v[5] == 1);
+
+        Vector<int, ReallocatingAllocator<int>> realloc_v;
+        realloc_v.Append(values);
+        realloc_v.Insert(realloc_v.cbegin() + 1, SIZE, realloc_v[3]);
+        assert(realloc_v.Size() == SIZE + 4);
+        assert(realloc_v[0] == 1 && realloc_v[1] == 4 && realloc_v[SIZE] == 4 && realloc_v[SIZE + 1] == 2);
+
+        v.Assign(std::vector<int>{9, 8});
+        assert(v.Size() == 2 && v[0] == 9 && v[1] == 8);
+        v.Assign(SIZE * 10, 3);
+        assert(v.Size() == SIZE * 10);
+        assert(std::all_of(v.begin(), v.end(), [](int x) {
+            return x == 3;
+        }));
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> src(SIZE);
+        src[SIZE - 1].throw_on_copy = true;
+        Vector<Obj> dst(2);
+        try {
+            // Присваивание с перераспределением даёт строгую гарантию
+            dst.Assign(src.begin(), src.end());
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(dst.Size() == 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+void Test13() {
+    const size_t SIZE = 100;
+    {
+        Vector<char> v(SIZE, default_init);
+        assert(v.Size() == SIZE);
+        assert(v.Capacity() == SIZE);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        v.ResizeDefaultInit(1);
+        assert(v.Size() == 1);
+    }
+    {
+        Obj::ResetCounters();
         {
-            cerr << "Vector:"sv << endl;
-            C::Reset();
-            Vector<C> v(NUM);
-            Dump();
-            v.PushBack(c);
+            Vector<Obj> v(SIZE, default_init);
+            v.ResizeDefaultInit(SIZE * 2);
+            assert(Obj::num_default_constructed == static_cast<int>(SIZE * 2));
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        using namespace std::literals;
+        const std::string payload = "payload"s;
+        Vector<char> v;
+        v.PushBack('>');
+        v.ResizeAndOverwrite(SIZE, [&payload](char* data, size_t size) {
+            assert(size == SIZE);
+            assert(data[0] == '>');
+            std::copy(payload.begin(), payload.end(), data + 1);
+            return payload.size() + 1;
+        });
+        assert(v.Size() == payload.size() + 1);
+        assert(v.Capacity() == SIZE);
+        assert(std::equal(v.begin() + 1, v.end(), payload.begin(), payload.end()));
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        try {
+            v.ResizeAndOverwrite(SIZE * 2, [](Obj* /*data*/, size_t /*size*/) -> size_t {
+                throw std::runtime_error("Oops");
+            });
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE));
+        v.ResizeAndOverwrite(SIZE / 2, [](Obj* data, size_t size) {
+            data[0].id = 1;
+            return size - 1;
+        });
+        assert(v.Size() == SIZE / 2 - 1);
+        assert(v[0].id == 1);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE / 2 - 1));
+    }
+}
+
+void Test14() {
+    const int SIZE = 10;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(i);
+        }
+        Obj::ResetCounters();
+        auto* pos = v.Erase(v.cbegin() + 2, v.cbegin() + 5);
+        assert(pos == &v[2]);
+        assert(v.Size() == static_cast<size_t>(SIZE - 3));
+        assert(v[1].id == 1 && v[2].id == 5 && v[SIZE - 4].id == SIZE - 1);
+        assert(Obj::num_move_assigned == SIZE - 5);
+        assert(Obj::num_destroyed == 3);
+        assert(v.Erase(v.cbegin() + 1, v.cbegin() + 1) == &v[1]);
+        assert(v.Size() == static_cast<size_t>(SIZE - 3));
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(i);
+        }
+        Obj::ResetCounters();
+        const size_t erased = EraseIf(v, [](const Obj& obj) {
+            return obj.id % 3 == 0;
+        });
+        assert(erased == 4);
+        const std::vector<int> expected{1, 2, 4, 5, 7, 8};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end(), [](const Obj& obj, int id) {
+            return obj.id == id;
+        }));
+        // Каждый оставшийся элемент переносится не более одного раза
+        assert(Obj::num_move_assigned == 6);
+        assert(Obj::num_copied == 0);
+        assert(Obj::num_destroyed == 4);
+        assert(EraseIf(v, [](const Obj&) {
+            return false;
+        }) == 0);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(i);
+        }
+        Obj::ResetCounters();
+        auto* pos = v.SwapErase(v.cbegin() + 1);
+        assert(pos->id == SIZE - 1);
+        assert(v.Size() == static_cast<size_t>(SIZE - 1));
+        assert(Obj::num_move_assigned == 1);
+        assert(Obj::num_destroyed == 1);
+        v.SwapErase(v.cend() - 1);
+        assert(v.Size() == static_cast<size_t>(SIZE - 2));
+        assert(v[SIZE - 3].id == SIZE - 3);
+    }
+}
+
+void Test15() {
+    const size_t SIZE = 64;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Resize(SIZE / 2);
+        assert(v.Capacity() == SIZE);
+        v.ShrinkToFit();
+        assert(v.Capacity() == SIZE / 2);
+        assert(v.Size() == SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(SIZE / 2));
+        v.Clear();
+        assert(v.Size() == 0);
+        assert(v.Capacity() == SIZE / 2);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
+        v.Resize(SIZE);
+        v.ClearAndRelease();
+        assert(v.Size() == 0);
+        assert(v.Capacity() == 0);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Vector<int, ReallocatingAllocator<int>> v(SIZE);
+        v[1] = 1;
+        v.Resize(2);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 2);
+        assert(v[1] == 1);
+    }
+    {
+        Vector<int, std::allocator<int>, AutoShrinkGrowth<>> v(SIZE);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v[i] = static_cast<int>(i);
+        }
+        // Пока размер не опустился ниже четверти ёмкости, буфер сохраняется
+        v.Erase(v.begin(), v.begin() + SIZE / 2);
+        assert(v.Capacity() == SIZE);
+        v.Resize(SIZE / 4);
+        assert(v.Capacity() == SIZE);
+        v.PopBack();
+        assert(v.Size() == SIZE / 4 - 1);
+        assert(v.Capacity() == (SIZE / 4 - 1) * 2);
+        assert(v[0] == static_cast<int>(SIZE / 2));
+        auto* pos = v.Erase(v.begin() + 1);
+        assert(pos == &v[1]);
+        assert(*pos == static_cast<int>(SIZE / 2 + 2));
+        // Clear сохраняет ёмкость и при автоматическом уменьшении
+        const size_t capacity = v.Capacity();
+        v.Clear();
+        assert(v.Capacity() == capacity);
+    }
+}
+
+void Test16() {
+    const int SIZE = 1000;
+    {
+        Obj::ResetCounters();
+        {
+            Vector<Obj> v;
+            v.Reserve(SIZE);
+            for (int i = 1; i <= SIZE; ++i) {
+                v.EmplaceBack(i);
+            }
+        }
+        // Каждый элемент разрушен ровно один раз: при повторном разрушении одного
+        // и того же элемента сумма идентификаторов не сошлась бы
+        assert(Obj::num_destroyed == SIZE);
+        assert(Obj::destroyed_id_sum == SIZE * (SIZE + 1) / 2);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Vector<std::unique_ptr<int>> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(std::make_unique<int>(i));
+        }
+        v.Emplace(v.begin(), std::make_unique<int>(-1));
+        assert(*v[0] == -1);
+        for (int i = 0; i < SIZE; ++i) {
+            assert(*v[i + 1] == i);
+        }
+    }
+    {
+        Vector<std::string> v;
+        v.Assign(SIZE, std::string(100, 'x'));
+        v.Insert(v.cbegin() + 1, std::string(200, 'y'));
+        assert(v.Size() == static_cast<size_t>(SIZE + 1));
+    }
+}
+
+struct C {
+    C() noexcept {
+        ++def_ctor;
+    }
+    C(const C& /*other*/) noexcept {
+        ++copy_ctor;
+    }
+    C(C&& /*other*/) noexcept {
+        ++move_ctor;
+    }
+    C& operator=(const C& other) noexcept {
+        if (this != &other) {
+            ++copy_assign;
+        }
+        return *this;
+    }
+    C& operator=(C&& /*other*/) noexcept {
+        ++move_assign;
+        return *this;
+    }
+    ~C() {
+        ++dtor;
+    }
+
+    static void Reset() {
+        def_ctor = 0;
+        copy_ctor = 0;
+        move_ctor = 0;
+        copy_assign = 0;
+        move_assign = 0;
+        dtor = 0;
+    }
+
+    inline static size_t def_ctor = 0;
+    inline static size_t copy_ctor = 0;
+    inline static size_t move_ctor = 0;
+    inline static size_t copy_assign = 0;
+    inline static size_t move_assign = 0;
+    inline static size_t dtor = 0;
+};
+
+// Vector выполняет столько же операций над элементами, сколько std::vector
+void Test17() {
+    const size_t NUM = 10;
+    struct Counts {
+        size_t def_ctor;
+        size_t copy_ctor;
+        size_t move_ctor;
+        size_t copy_assign;
+        size_t move_assign;
+        size_t dtor;
+
+        static Counts Take() {
+            return {C::def_ctor, C::copy_ctor, C::move_ctor, C::copy_assign, C::move_assign, C::dtor};
+        }
+
+        bool operator==(const Counts& other) const {
+            return def_ctor == other.def_ctor && copy_ctor == other.copy_ctor && move_ctor == other.move_ctor
+                && copy_assign == other.copy_assign && move_assign == other.move_assign && dtor == other.dtor;
+        }
+    };
+    C c;
+    Counts std_counts{};
+    {
+        C::Reset();
+        {
+            std::vector<C> v(NUM);
+            v.push_back(c);
+        }
+        std_counts = Counts::Take();
+    }
+    Counts counts{};
+    {
+        C::Reset();
+        {
+            Vector<C> v(NUM);
+            v.PushBack(c);
+        }
+        counts = Counts::Take();
+    }
+    assert(counts == std_counts);
+    assert(counts.def_ctor == NUM);
+    assert(counts.copy_ctor == 1);
+    assert(counts.move_ctor == NUM);
+    assert(counts.dtor == NUM + 1 + NUM);
+}
+
+// Статистика смен буфера
+void Test18() {
+    struct Sample {
+        int value = 0;
+    };
+    static_assert(sizeof(Vector<Sample>) == sizeof(InstrumentedVector<Sample>));
+    VectorStats::Reset<Sample>();
+    {
+        InstrumentedVector<Sample> v;
+        // Пустой вектор без буфера не учитывается
+        InstrumentedVector<Sample> empty;
+    }
+    assert(VectorStats::Snapshot<Sample>().releases == 0);
+    {
+        InstrumentedVector<Sample> v;
+        for(int i = 0; i < 5; ++i) {
+            v.PushBack(Sample{i});
+        }
+        // Ёмкость растёт 1 -> 2 -> 4 -> 8, перенесено 0 + 1 + 2 + 4 элементов
+        VectorStatsSnapshot snapshot = VectorStats::Snapshot<Sample>();
+        assert(snapshot.reallocations == 4);
+        assert(snapshot.bytes_moved == 7 * sizeof(Sample));
+        assert(snapshot.peak_capacity == 8);
+        assert(snapshot.element_size == sizeof(Sample));
+        assert(snapshot.type_name != nullptr);
+
+        v.Reserve(8);
+        assert(VectorStats::Snapshot<Sample>().reallocations == 4);
+        v.Reserve(20);
+        v.Insert(v.begin(), 20, Sample{});
+        v.ShrinkToFit();
+        snapshot = VectorStats::Snapshot<Sample>();
+        assert(snapshot.reallocations == 7);
+        assert(snapshot.bytes_moved == (7 + 5 + 5 + 25) * sizeof(Sample));
+        assert(snapshot.peak_capacity == 40);
+        v.Resize(20);
+    }
+    VectorStatsSnapshot snapshot = VectorStats::Snapshot<Sample>();
+    assert(snapshot.releases == 1);
+    assert(snapshot.wasted_bytes == 5 * sizeof(Sample));
+
+    // От буфера отказываются и присваивание, ClearAndRelease, Release и Adopt
+    VectorStats::Reset<Sample>();
+    {
+        InstrumentedVector<Sample> big(10);
+        InstrumentedVector<Sample> v;
+        v.Reserve(8);
+        v.PushBack(Sample{1});
+        InstrumentedVector<Sample> other;
+        other.Reserve(4);
+        other.Resize(3);
+        v = std::move(other);
+        snapshot = VectorStats::Snapshot<Sample>();
+        assert(snapshot.releases == 1 && snapshot.wasted_bytes == 7 * sizeof(Sample));
+        v.ClearAndRelease();
+        snapshot = VectorStats::Snapshot<Sample>();
+        assert(snapshot.releases == 2 && snapshot.wasted_bytes == 8 * sizeof(Sample));
+        v.Reserve(5);
+        v.Resize(2);
+        v = big;
+        snapshot = VectorStats::Snapshot<Sample>();
+        assert(snapshot.releases == 3 && snapshot.wasted_bytes == 11 * sizeof(Sample));
+        OwnedBuffer<Sample> owned = v.Release();
+        assert(VectorStats::Snapshot<Sample>().releases == 4);
+        InstrumentedVector<Sample> adopter(2);
+        adopter.Reserve(6);
+        adopter.Adopt(std::move(owned));
+        snapshot = VectorStats::Snapshot<Sample>();
+        assert(snapshot.releases == 5 && snapshot.wasted_bytes == 15 * sizeof(Sample));
+    }
+    snapshot = VectorStats::Snapshot<Sample>();
+    assert(snapshot.releases == 7 && snapshot.wasted_bytes == 15 * sizeof(Sample));
+
+    // Assign, которому не хватило ёмкости, тоже отказывается от прежнего буфера
+    VectorStats::Reset<Sample>();
+    {
+        InstrumentedVector<Sample> v(5);
+        v.Resize(4);
+        v.Assign(10, Sample{});
+        snapshot = VectorStats::Snapshot<Sample>();
+        assert(snapshot.releases == 1 && snapshot.wasted_bytes == 1 * sizeof(Sample));
+        const Vector<Sample> source(20);
+        v.Assign(source.begin(), source.end());
+        assert(VectorStats::Snapshot<Sample>().releases == 2);
+        v.Assign(parallel, 30, Sample{});
+        assert(VectorStats::Snapshot<Sample>().releases == 3);
+        v.Assign(5, Sample{});
+        assert(VectorStats::Snapshot<Sample>().releases == 3 && v.Capacity() == 30);
+    }
+    assert(VectorStats::Snapshot<Sample>().releases == 4);
+
+    // Неудавшаяся смена буфера не записывается
+    {
+        VectorStats::Reset<Obj>();
+        InstrumentedVector<Obj> v(1);
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.EmplaceBack();
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        Obj::default_construction_throw_countdown = 0;
+        assert(VectorStats::Snapshot<Obj>().reallocations == 0);
+    }
+
+    bool found = false;
+    for(const VectorStatsSnapshot& entry : VectorStats::SnapshotAll()) {
+        found = found || std::string(entry.type_name) == typeid(Sample).name();
+    }
+    assert(found);
+}
+
+// Конкурентное добавление элементов
+void Test19() {
+    {
+        const size_t NUM_THREADS = 8;
+        const size_t PER_THREAD = 10000;
+        ConcurrentVector<std::pair<size_t, size_t>> v;
+        const size_t first = v.PushBack({NUM_THREADS, 0});
+        assert(first == 0);
+        // Ссылки не меняются при росте
+        const auto* first_ptr = &v[0];
+
+        std::vector<std::thread> threads;
+        std::vector<std::vector<size_t>> indices(NUM_THREADS);
+        for(size_t t = 0; t < NUM_THREADS; ++t) {
+            threads.emplace_back([&v, &indices, t] {
+                for(size_t i = 0; i < PER_THREAD; ++i) {
+                    const size_t index = v.EmplaceBack(t, i);
+                    assert(v.IsPublished(index));
+                    assert(v[index].first == t && v[index].second == i);
+                    indices[t].push_back(index);
+                }
+            });
+        }
+        for(auto& thread : threads) {
+            thread.join();
+        }
+        assert(v.Size() == NUM_THREADS * PER_THREAD + 1);
+        assert(&v[0] == first_ptr);
+        for(size_t t = 0; t < NUM_THREADS; ++t) {
+            for(size_t i = 0; i < PER_THREAD; ++i) {
+                assert(v[indices[t][i]].first == t && v[indices[t][i]].second == i);
+            }
+        }
+
+        Vector<std::pair<size_t, size_t>> frozen = v.Freeze();
+        assert(v.Size() == 0);
+        assert(frozen.Size() == NUM_THREADS * PER_THREAD + 1);
+        for(size_t t = 0; t < NUM_THREADS; ++t) {
+            for(size_t i = 0; i < PER_THREAD; ++i) {
+                assert(frozen[indices[t][i]].first == t && frozen[indices[t][i]].second == i);
+            }
+        }
+    }
+    {
+        // Номер элемента, конструктор которого выбросил исключение, остаётся неопубликованным
+        Obj::ResetCounters();
+        {
+            ConcurrentVector<Obj> v;
+            v.EmplaceBack();
+            Obj::default_construction_throw_countdown = 1;
+            try {
+                v.EmplaceBack();
+                assert(false);
+            } catch (const std::runtime_error&) {
+            }
+            v.EmplaceBack(7);
+            assert(v.Size() == 3);
+            assert(v.IsPublished(0) && !v.IsPublished(1) && v.IsPublished(2));
+            assert(!v.IsPublished(3));
+            assert(Obj::GetAliveObjectCount() == 2);
+
+            Vector<Obj> frozen = v.Freeze();
+            assert(frozen.Size() == 2);
+            assert(frozen[1].id == 7);
+            assert(Obj::GetAliveObjectCount() == 2);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+// Вектор со стабильными адресами элементов
+void Test20() {
+    static_assert(std::is_same_v<std::iterator_traits<SegmentedVector<int>::iterator>::iterator_category,
+                                 std::random_access_iterator_tag>);
+    const size_t SIZE = 1000;
+    {
+        SegmentedVector<int> v;
+        v.PushBack(0);
+        int* first = &v[0];
+        for(size_t i = 1; i < SIZE; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        // Рост не переносит элементы
+        assert(&v[0] == first);
+        assert(v.Size() == SIZE);
+        for(size_t i = 0; i < SIZE; ++i) {
+            assert(v[i] == static_cast<int>(i));
+        }
+        assert(std::is_sorted(v.begin(), v.end()));
+        assert(v.end() - v.begin() == static_cast<std::ptrdiff_t>(SIZE));
+        assert(*(v.begin() + 500) == 500);
+
+        // Сегменты вместе покрывают все элементы по порядку
+        const size_t first_size = SegmentedVector<int>::FIRST_SEGMENT_SIZE;
+        size_t covered = 0;
+        for(size_t k = 0; k < v.SegmentCount(); ++k) {
+            Span<int> segment = v.GetSegment(k);
+            assert(segment[0] == static_cast<int>(covered));
+            assert(k + 1 == v.SegmentCount() || segment.Size() == first_size << k);
+            covered += segment.Size();
+        }
+        assert(covered == SIZE);
+        long long sum = 0;
+        for(size_t k = 0; k < v.SegmentCount(); ++k) {
+            Span<const int> segment = std::as_const(v).GetSegment(k);
+            sum = std::accumulate(segment.begin(), segment.end(), sum);
+        }
+        assert(sum == static_cast<long long>(SIZE * (SIZE - 1) / 2));
+
+        v.Resize(10);
+        assert(v.Size() == 10 && v.SegmentCount() == 1);
+        const size_t capacity = v.Capacity();
+        v.Clear();
+        assert(v.Size() == 0 && v.Capacity() == capacity);
+        v.ClearAndRelease();
+        assert(v.Capacity() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            SegmentedVector<Obj> v(SIZE);
+            assert(Obj::num_default_constructed == SIZE);
+            SegmentedVector<Obj> copy(v);
+            assert(Obj::num_copied == SIZE);
+            SegmentedVector<Obj> moved(std::move(v));
+            assert(v.Size() == 0 && moved.Size() == SIZE);
+            copy = moved;
+            assert(Obj::num_copied == 2 * SIZE);
+            copy = std::move(moved);
+            assert(Obj::num_moved == 0);
+            assert(copy.Size() == SIZE);
+            copy.PopBack();
+            assert(copy.Size() == SIZE - 1);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // При исключении в конструкторе элемента вектор не меняется
+        Obj::ResetCounters();
+        SegmentedVector<Obj> v(SegmentedVector<Obj>::FIRST_SEGMENT_SIZE);
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.EmplaceBack();
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SegmentedVector<Obj>::FIRST_SEGMENT_SIZE);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(v.Size()));
+    }
+    {
+        SegmentedVector<int, CountingAllocator<int>> lhs{CountingAllocator<int>(1)};
+        SegmentedVector<int, CountingAllocator<int>> rhs{CountingAllocator<int>(2)};
+        lhs.Resize(100);
+        rhs.PushBack(5);
+        lhs.Swap(rhs);
+        assert(lhs.Size() == 1 && lhs[0] == 5 && lhs.GetAllocator().id == 2);
+        assert(rhs.Size() == 100 && rhs.GetAllocator().id == 1);
+    }
+}
+
+// Параллельное создание элементов
+void Test21() {
+    // Маленькие части, чтобы создание действительно распределялось по потокам
+    const ParallelPolicy policy{4, 1};
+    const size_t SIZE = 1001;
+    static_assert(!std::is_constructible_v<Vector<int>, int, size_t>);
+    {
+        Vector<int> v(policy, SIZE);
+        assert(v.Size() == SIZE && std::all_of(v.begin(), v.end(), [](int x) { return x == 0; }));
+        std::iota(v.begin(), v.end(), 0);
+        Vector<int> copy(policy, v);
+        assert(std::equal(v.begin(), v.end(), copy.begin(), copy.end()));
+        copy.Resize(policy, 2 * SIZE);
+        assert(copy.Size() == 2 * SIZE && copy[SIZE - 1] == static_cast<int>(SIZE - 1) && copy[SIZE] == 0);
+        copy.Resize(policy, 10);
+        assert(copy.Size() == 10);
+        copy.Assign(policy, SIZE, 7);
+        assert(copy.Size() == SIZE && std::all_of(copy.begin(), copy.end(), [](int x) { return x == 7; }));
+        copy.Assign(policy, 3 * SIZE, copy[0]);
+        assert(copy.Size() == 3 * SIZE && std::all_of(copy.begin(), copy.end(), [](int x) { return x == 7; }));
+        Vector<int> uninitialized(policy, SIZE, default_init);
+        assert(uninitialized.Size() == SIZE);
+        Vector<int> serial(parallel, 10);
+        assert(serial.Size() == 10);
+    }
+    {
+        Vector<AtomicObj> v(policy, SIZE);
+        assert(AtomicObj::num_alive == static_cast<int>(SIZE));
+        AtomicObj::num_copied = 0;
+        Vector<AtomicObj> copy(policy, v);
+        assert(AtomicObj::num_copied == static_cast<int>(SIZE));
+        // Исключение в одной из частей откатывает все уже созданные части
+        v[SIZE / 2 + 1].value = AtomicObj::POISON;
+        try {
+            Vector<AtomicObj> failed(policy, v);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(AtomicObj::num_alive == static_cast<int>(2 * SIZE));
+        try {
+            copy.Assign(policy, SIZE, v[SIZE / 2 + 1]);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(copy.Size() == SIZE);
+        assert(AtomicObj::num_alive == static_cast<int>(2 * SIZE));
+        copy.Clear();
+
+        AtomicObj::throw_on_default_construction = true;
+        try {
+            v.Resize(policy, 2 * SIZE);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        AtomicObj::throw_on_default_construction = false;
+        assert(v.Size() == SIZE);
+        assert(AtomicObj::num_alive == static_cast<int>(SIZE));
+    }
+    assert(AtomicObj::num_alive == 0);
+}
+
+// Буферы на огромных страницах и узлах NUMA
+void Test22() {
+    const size_t SIZE = (size_t{4} << 20) / sizeof(float) + 1;
+    for(PageKind kind : {PageKind::REGULAR, PageKind::TRANSPARENT_HUGE, PageKind::HUGE_2MB}) {
+        for(NumaPolicy numa : {NumaPolicy::LOCAL, NumaPolicy::BIND, NumaPolicy::INTERLEAVE}) {
+            PageOptions options;
+            options.page_kind = kind;
+            options.numa_policy = numa;
+            options.node_mask = 1;
+            const HugePageAllocator<float> alloc(options);
+            // Без огромных страниц и NUMA блок всё равно выделяется
+            Vector<float, HugePageAllocator<float>> v(alloc);
+            v.Resize(SIZE);
+            assert(reinterpret_cast<uintptr_t>(v.begin()) % 4096 == 0);
+            v[SIZE - 1] = 1.0f;
+            Vector<float, HugePageAllocator<float>> copy(v);
+            assert(copy[SIZE - 1] == 1.0f && copy[0] == 0.0f);
+            assert(copy.GetAllocator().GetOptions().page_kind == kind);
+
+            // Маленькие буферы выделяются через operator new
+            Vector<float, HugePageAllocator<float>> small(alloc);
+            small.PushBack(2.0f);
+            small.Swap(v);
+            assert(v.Size() == 1 && small.Size() == SIZE);
+        }
+    }
+    {
+        PageOptions options;
+        options.page_kind = PageKind::REGULAR;
+        options.min_mapped_bytes = 1;
+        Vector<std::string, HugePageAllocator<std::string>> v{HugePageAllocator<std::string>(options)};
+        for(int i = 0; i < 100; ++i) {
+            v.EmplaceBack(std::to_string(i));
+        }
+        assert(v[99] == "99");
+        assert(HugePageAllocator<int>(options) != HugePageAllocator<int>());
+        assert(HugePageAllocator<int>(options) == HugePageAllocator<int>(HugePageAllocator<char>(options)));
+    }
+}
+
+// Выровненные буферы с хвостовым запасом
+void Test23() {
+    static_assert(Vector<int>::ALIGNMENT == alignof(int));
+    static_assert(AlignedVector<float>::ALIGNMENT == 64);
+    static_assert(Vector<char, AlignedAllocator<char, 32, 0>>::ALIGNMENT == 32);
+    static_assert(std::is_same_v<std::allocator_traits<AlignedAllocator<int, 32, 16>>::rebind_alloc<char>,
+                                 AlignedAllocator<char, 32, 16>>);
+    {
+        AlignedVector<float> v;
+        assert(v.AssumeAligned() == nullptr);
+        for(int i = 0; i < 1000; ++i) {
+            v.PushBack(static_cast<float>(i));
+            assert(reinterpret_cast<uintptr_t>(v.AssumeAligned()) % 64 == 0);
+        }
+        // Полный регистр AVX-512 за концом буфера читается без выхода за пределы блока
+        const size_t padding = AlignedAllocator<float>::PADDING_BYTES;
+        const unsigned char* tail = reinterpret_cast<const unsigned char*>(v.AssumeAligned() + v.Capacity());
+        for(size_t i = 0; i < padding; ++i) {
+            assert(tail[i] == 0);
+        }
+        float sum = 0;
+        const float* data = v.AssumeAligned();
+        for(size_t i = 0; i < v.Size(); ++i) {
+            sum += data[i];
+        }
+        assert(sum == 999.0f * 1000.0f / 2.0f);
+        AlignedVector<float> copy(v);
+        assert(reinterpret_cast<uintptr_t>(std::as_const(copy).AssumeAligned()) % 64 == 0);
+    }
+    {
+        Vector<std::string, AlignedAllocator<std::string, 128>> v;
+        v.Resize(10);
+        v[9] = "aligned";
+        assert(reinterpret_cast<uintptr_t>(v.AssumeAligned()) % 128 == 0);
+    }
+}
+
+// Вектор в отображённом в память файле
+void Test24() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct Record {
+        int id;
+        double value;
+    };
+    const size_t SIZE = 10000;
+    const std::string path = (std::filesystem::temp_directory_path() / "advanced_vector_mapped_test.bin").string();
+    {
+        MappedVector<Record> v(path, MapMode::CREATE);
+        assert(v.Size() == 0 && v.begin() == v.end());
+        for(size_t i = 0; i < SIZE; ++i) {
+            v.PushBack(Record{static_cast<int>(i), i * 0.5});
+        }
+        // Аргумент, ссылающийся на запись, переживает перенос отображения
+        v.Reserve(v.Size());
+        v.PushBack(v[0]);
+        assert(v[SIZE].id == 0);
+        v.PopBack();
+        v.Flush();
+        assert(v.Capacity() >= SIZE);
+    }
+    assert(std::filesystem::file_size(path) == SIZE * sizeof(Record));
+    {
+        const MappedVector<Record> v(path, MapMode::READ_ONLY);
+        assert(v.IsReadOnly() && v.Size() == SIZE);
+        for(size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i) && v[i].value == i * 0.5);
+        }
+        MappedVector<Record> moved(path, MapMode::READ_ONLY);
+        try {
+            moved.PushBack(Record{});
+            assert(false);
+        } catch (const std::logic_error&) {
+        }
+    }
+    {
+        MappedVector<Record> v(path, MapMode::READ_WRITE);
+        v.Resize(SIZE / 2);
+        v[0].value = -1.0;
+        v.Resize(SIZE / 2 + 1);
+        assert(v[SIZE / 2].id == 0 && v[SIZE / 2].value == 0.0);
+        MappedVector<Record> moved(std::move(v));
+        assert(moved.Size() == SIZE / 2 + 1 && v.Size() == 0);
+    }
+    assert(std::filesystem::file_size(path) == (SIZE / 2 + 1) * sizeof(Record));
+    {
+        MappedVector<Record> v(path, MapMode::READ_WRITE);
+        assert(v[0].value == -1.0);
+        v.Clear();
+    }
+    assert(std::filesystem::file_size(path) == 0);
+    std::filesystem::remove(path);
+    try {
+        MappedVector<Record> v(path, MapMode::READ_ONLY);
+        assert(false);
+    } catch (const std::system_error&) {
+    }
+#endif
+}
+
+// Двоичная сериализация
+void Test25() {
+    {
+        Vector<double> v;
+        for(int i = 0; i < 1000; ++i) {
+            v.PushBack(i * 0.25);
+        }
+        Vector<unsigned char> buffer;
+        MemoryWriter writer(buffer);
+        Serialize(v, writer);
+        assert(buffer.Size() == sizeof(SerializationHeader) + v.Size() * sizeof(double));
+
+        MemoryReader reader(Span<const unsigned char>(buffer.begin(), buffer.Size()));
+        const auto restored = Deserialize<Vector<double>>(reader);
+        assert(std::equal(v.begin(), v.end(), restored.begin(), restored.end()));
+
+        // Элементы читаются прямо из буфера без копирования
+        const Span<const double> view = DeserializeView<double>(Span<const unsigned char>(buffer.begin(), buffer.Size()));
+        assert(view.Size() == v.Size() && view[999] == v[999]);
+        assert(reinterpret_cast<const unsigned char*>(view.Data()) == buffer.begin() + sizeof(SerializationHeader));
+
+        // Несовпадение типа, порядка байтов и обрезанные данные обнаруживаются
+        const auto expect_error = [](Vector<unsigned char> bytes, auto read) {
+            try {
+                MemoryReader bad_reader(Span<const unsigned char>(bytes.begin(), bytes.Size()));
+                read(bad_reader);
+                assert(false);
+            } catch (const SerializationError&) {
+            }
+        };
+        expect_error(buffer, [](MemoryReader& r) { Deserialize<Vector<float>>(r); });
+        expect_error(buffer, [](MemoryReader& r) { Deserialize<Vector<std::string>>(r); });
+        Vector<unsigned char> truncated(buffer);
+        truncated.Resize(truncated.Size() - 1);
+        expect_error(truncated, [](MemoryReader& r) { Deserialize<Vector<double>>(r); });
+        Vector<unsigned char> swapped(buffer);
+        std::reverse(swapped.begin() + 8, swapped.begin() + 12);
+        expect_error(swapped, [](MemoryReader& r) { Deserialize<Vector<double>>(r); });
+        Vector<unsigned char> huge(buffer);
+        huge[31] = 0x7f;
+        expect_error(huge, [](MemoryReader& r) { Deserialize<Vector<double>>(r); });
+
+        // При ошибке вектор сохраняет прежнее содержимое
+        Vector<double> target(3);
+        try {
+            MemoryReader bad_reader(Span<const unsigned char>(truncated.begin(), truncated.Size()));
+            Deserialize(bad_reader, target);
+            assert(false);
+        } catch (const SerializationError&) {
+        }
+        assert(target.Size() == 3);
+    }
+    {
+        // Поэлементная запись строк и вложенных векторов через поток
+        Vector<Vector<std::string>> v(3);
+        v[0].PushBack("alpha");
+        v[2].PushBack(std::string(1000, 'x'));
+        v[2].PushBack("");
+        std::stringstream stream;
+        StreamWriter writer(stream);
+        Serialize(v, writer);
+        StreamReader reader(stream);
+        Vector<Vector<std::string>> restored;
+        Deserialize(reader, restored);
+        assert(restored.Size() == 3);
+        assert(restored[0].Size() == 1 && restored[0][0] == "alpha");
+        assert(restored[1].Size() == 0);
+        assert(restored[2].Size() == 2 && restored[2][0] == std::string(1000, 'x') && restored[2][1].empty());
+    }
+    {
+        // Элементы с выравниванием больше заголовка начинаются на его границе
+        struct alignas(64) Line {
+            uint64_t values[8];
+        };
+        Vector<Line> v(3);
+        v[2].values[7] = 42;
+        Vector<unsigned char> buffer;
+        MemoryWriter writer(buffer);
+        Serialize(v, writer);
+        assert(buffer.Size() == 64 + 3 * sizeof(Line));
+        alignas(64) unsigned char aligned[64 + 3 * sizeof(Line)];
+        std::memcpy(aligned, buffer.begin(), sizeof(aligned));
+        const Span<const Line> view = DeserializeView<Line>(Span<const unsigned char>(aligned, sizeof(aligned)));
+        assert(view.Size() == 3 && view[2].values[7] == 42);
+        MemoryReader reader(Span<const unsigned char>(buffer.begin(), buffer.Size()));
+        assert(Deserialize<Vector<Line>>(reader)[2].values[7] == 42);
+    }
+}
+
+// Передача владения буферами
+void Test26() {
+    static int num_freed = 0;
+    const auto free_buffer = [](auto* buffer, size_t /*capacity*/) {
+        ++num_freed;
+        std::free(buffer);
+    };
+    {
+        // Буфер, выделенный вне вектора, освобождается своим способом при переезде
+        num_freed = 0;
+        int* buffer = static_cast<int*>(std::malloc(4 * sizeof(int)));
+        for(int i = 0; i < 3; ++i) {
+            buffer[i] = i;
+        }
+        Vector<int> v;
+        v.Adopt(buffer, 3, 4, free_buffer);
+        assert(v.begin() == buffer && v.Size() == 3 && v.Capacity() == 4);
+        v.PushBack(3);
+        assert(num_freed == 0);
+        v.PushBack(4);
+        assert(num_freed == 1);
+        assert(v[0] == 0 && v[4] == 4);
+    }
+    {
+        // Release отдаёт буфер без копирования, Adopt принимает его обратно
+        num_freed = 0;
+        Vector<std::string> v;
+        v.PushBack("payload");
+        v.PushBack("message");
+        const std::string* data = v.begin();
+        OwnedBuffer<std::string> owned = v.Release();
+        assert(v.Size() == 0 && v.Capacity() == 0 && v.begin() == nullptr);
+        assert(owned.Data() == data && owned.Size() == 2 && owned.Capacity() == 2);
+        Vector<std::string> other;
+        other.PushBack("old");
+        other.Adopt(std::move(owned));
+        assert(owned.Data() == nullptr);
+        assert(other.begin() == data && other.Size() == 2 && other[1] == "message");
+
+        // Повторный Release принятого буфера сохраняет исходный способ освобождения
+        Obj::ResetCounters();
+        Obj* objs = static_cast<Obj*>(std::malloc(3 * sizeof(Obj)));
+        new (objs) Obj(1);
+        new (objs + 1) Obj(2);
+        {
+            Vector<Obj> obj_vector;
+            obj_vector.Adopt(objs, 2, 3, free_buffer);
+            obj_vector.EmplaceBack(3);
+            OwnedBuffer<Obj> released = obj_vector.Release();
+            assert(released.Size() == 3);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+        assert(Obj::destroyed_id_sum == 6);
+        assert(num_freed == 1);
+    }
+    {
+        // Принятый буфер не отдаётся аллокатору для расширения на месте
+        num_freed = 0;
+        int* buffer = static_cast<int*>(std::malloc(2 * sizeof(int)));
+        buffer[0] = 10;
+        Vector<int, ReallocatingAllocator<int>> v;
+        v.Adopt(buffer, 1, 2, free_buffer);
+        v.Reserve(1000);
+        assert(num_freed == 1);
+        assert(v.Size() == 1 && v[0] == 10);
+    }
+}
+
+// Вектор со столбцовым хранением полей
+void Test27() {
+    {
+        SoaVector<double, int, std::string> orders;
+        for(int i = 0; i < 100; ++i) {
+            orders.EmplaceBack(i * 1.5, i, "order" + std::to_string(i));
+        }
+        assert(orders.Size() == 100 && orders.Capacity() >= 100);
+
+        // Столбцы лежат непрерывно и читаются независимо
+        const Span<const double> prices = std::as_const(orders).Column<0>();
+        const Span<int> quantities = orders.Column<1>();
+        assert(prices.Size() == 100 && quantities.Size() == 100);
+        double turnover = 0;
+        for(size_t i = 0; i < prices.Size(); ++i) {
+            turnover += prices[i] * quantities[i];
+        }
+        assert(turnover == 1.5 * 99 * 100 * 199 / 6);
+
+        auto [price, quantity, name] = orders[10];
+        assert(price == 15.0 && quantity == 10 && name == "order10");
+        quantity = 7;
+        assert(orders.Column<1>()[10] == 7);
+        orders[11] = std::make_tuple(0.5, 1, std::string("replaced"));
+        assert(std::get<2>(orders[11]) == "replaced");
+
+        // Аргумент, ссылающийся на поле, переживает рост
+        SoaVector<double, int, std::string> copy(orders);
+        copy.Reserve(copy.Size());
+        copy.EmplaceBack(std::get<0>(copy[0]), std::get<1>(copy[0]), std::get<2>(copy[99]));
+        assert(std::get<2>(copy[100]) == "order99");
+        assert(std::get<2>(orders[99]) == "order99");
+
+        orders = copy;
+        assert(orders.Size() == 101);
+        orders.PopBack();
+        orders.Resize(5);
+        assert(orders.Size() == 5 && std::get<2>(orders[4]) == "order4");
+        orders.Resize(6);
+        assert(std::get<2>(orders[5]).empty() && std::get<0>(orders[5]) == 0.0);
+        SoaVector<double, int, std::string> moved(std::move(orders));
+        assert(moved.Size() == 6 && orders.Size() == 0);
+        orders = std::move(moved);
+        assert(orders.Size() == 6);
+        orders.Clear();
+        assert(orders.Size() == 0);
+    }
+    {
+        // Исключение при создании поля откатывает строку целиком
+        Obj::ResetCounters();
+        SoaVector<std::string, Obj> v;
+        v.EmplaceBack("first", 1);
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.EmplaceBack("second", Obj{});
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == 1 && std::get<0>(v[0]) == "first" && std::get<1>(v[0]).id == 1);
+        v.Resize(10);
+        assert(Obj::GetAliveObjectCount() == 10);
+        v.Clear();
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+// Векторные алгоритмы на каждом доступном наборе инструкций
+template <typename T>
+void CheckVectorAlgorithms() {
+    Vector<T> values(1000);
+    for(size_t i = 0; i < values.Size(); ++i) {
+        values[i] = static_cast<T>(static_cast<int>(i * 7919 % 1009) - 500);
+    }
+    // Все длины до нескольких регистров и невыровненные начала проверяют обработку остатка
+    for(size_t offset = 0; offset < 3; ++offset) {
+        for(size_t size = 0; size + offset <= values.Size(); size = size < 70 ? size + 1 : size * 3) {
+            const Span<const T> range(values.begin() + offset, size);
+            const T* first = range.begin();
+            const T* last = range.end();
+            for(const T needle : {T(0), T(-500), T(123), T(10'000)}) {
+                assert(Find(range, needle) == std::find(first, last, needle));
+                assert(Count(range, needle) == static_cast<size_t>(std::count(first, last, needle)));
+            }
+            assert(Sum(range) == std::accumulate(first, last, SumResult<T>{}));
+            if(size != 0) {
+                const auto [min, max] = MinMax(range);
+                assert(min == *std::min_element(first, last) && max == *std::max_element(first, last));
+            }
+
+            Vector<T> copy(size);
+            std::copy(first, last, copy.begin());
+            assert(Equal(Span<T>(copy.begin(), size), range));
+            if(size != 0) {
+                copy[size - 1] = T(20'000);
+                assert(!Equal(Span<T>(copy.begin(), size), range));
+            }
+            Fill(copy, T(42));
+            assert(Count(copy, T(42)) == size);
+        }
+    }
+
+    Vector<T> other = values;
+    assert(Equal(values, other) && *Find(values, T(-500)) == T(-500));
+    other.PopBack();
+    assert(!Equal(values, other));
+    *Find(other, T(-500)) = T(1);
+    assert(Find(other, T(-500)) == other.end());
+}
+
+void Test28() {
+    const SimdLevel detected = GetSimdLevel();
+    assert(detected == DetectSimdLevel() && IsSimdLevelSupported(detected));
+    for(SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON}) {
+        if(!SetSimdLevel(level)) {
+            assert(!IsSimdLevelSupported(level) && GetSimdLevel() != level);
+            continue;
+        }
+        CheckVectorAlgorithms<int32_t>();
+        CheckVectorAlgorithms<float>();
+        CheckVectorAlgorithms<double>();
+        // Остальные типы обрабатываются обычными циклами
+        CheckVectorAlgorithms<int16_t>();
+    }
+    SetSimdLevel(detected);
+    {
+        // Сумма int32_t не переполняется
+        Vector<int32_t> big(100);
+        Fill(big, std::numeric_limits<int32_t>::max());
+        assert(Sum(big) == int64_t{100} * std::numeric_limits<int32_t>::max());
+        // Отрицательный и положительный нули равны, NaN не равен ничему
+        Vector<double> zeros(20);
+        Fill(zeros, -0.0);
+        assert(Count(zeros, 0.0) == 20);
+        Vector<float> nans(20);
+        Fill(nans, std::numeric_limits<float>::quiet_NaN());
+        assert(Find(nans, nans[0]) == nans.end() && !Equal(nans, nans));
+    }
+}
+
+// Вставка в середину без перераспределения создаёт элемент на месте
+void Test29() {
+    const size_t SIZE = 10;
+    {
+        // Исключение в конструкторе возвращает сдвинутые элементы на место
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        for(size_t i = 0; i < SIZE; ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.Emplace(v.cbegin() + 2);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        Obj poisoned(100);
+        poisoned.throw_on_copy = true;
+        try {
+            v.Insert(v.cbegin() + 5, poisoned);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE && v.Capacity() == SIZE * 2);
+        for(size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i));
+        }
+        assert(Obj::GetAliveObjectCount() == SIZE + 1);
+    }
+    {
+        // Аргумент, ссылающийся на сдвигаемый элемент, копируется до сдвига
+        Vector<std::string> v;
+        v.Reserve(SIZE);
+        for(const char* s : {"a", "b", "c", "d"}) {
+            v.PushBack(s);
+        }
+        v.Emplace(v.cbegin() + 1, v[2]);
+        v.Emplace(v.cbegin(), v[3].c_str());
+        v.Emplace(v.cbegin() + 2, std::move(v[5]));
+        assert(v.Size() == 7);
+        assert(v[0] == "c" && v[1] == "a" && v[2] == "d" && v[3] == "c" && v[4] == "b" && v[5] == "c");
+
+        SmallVector<std::string, 8> small;
+        small.PushBack("x");
+        small.PushBack("y");
+        small.Emplace(small.cbegin(), small[1]);
+        assert(small.Size() == 3 && small[0] == "y" && small[1] == "x" && small[2] == "y");
+    }
+    {
+        // Тривиально перемещаемые элементы сдвигаются побайтово
+        Vector<RelocatableObj> v;
+        v.Reserve(SIZE);
+        for(int i = 0; i < 5; ++i) {
+            v.EmplaceBack(i);
+        }
+        RelocatableObj::num_moved = 0;
+        RelocatableObj::num_copied = 0;
+        v.Emplace(v.cbegin() + 1, 7);
+        v.Insert(v.cbegin(), v[4]);
+        assert(RelocatableObj::num_moved == 0 && RelocatableObj::num_copied == 1);
+        const int expected[] = {3, 0, 7, 1, 2, 3, 4};
+        for(size_t i = 0; i < v.Size(); ++i) {
+            assert(v[i].id == expected[i]);
+        }
+    }
+}
+
+// Присваивание выполняет минимум операций над элементами и выделений памяти
+void Test30() {
+    using CVector = Vector<C, CountingAllocator<C>>;
+    using Alloc = CountingAllocator<C>;
+    const size_t SMALL = 4;
+    const size_t LARGE = 10;
+    {
+        // Элементы rhs не помещаются: одно выделение ровно под rhs, только копирования
+        CVector dst(SMALL);
+        const CVector src(LARGE);
+        C::Reset();
+        Alloc::ResetCounters();
+        dst = src;
+        assert(dst.Size() == LARGE && dst.Capacity() == LARGE);
+        assert(Alloc::num_allocations == 1 && Alloc::num_deallocations == 1);
+        assert(C::copy_ctor == LARGE && C::copy_assign == 0 && C::dtor == SMALL);
+    }
+    {
+        // Элементы помещаются: без выделений, общая часть переприсваивается
+        CVector dst(SMALL);
+        dst.Reserve(LARGE);
+        const CVector src(LARGE);
+        C::Reset();
+        Alloc::ResetCounters();
+        dst = src;
+        assert(Alloc::num_allocations == 0 && Alloc::num_deallocations == 0);
+        assert(C::copy_assign == SMALL && C::copy_ctor == LARGE - SMALL && C::dtor == 0);
+
+        const CVector shorter(SMALL);
+        C::Reset();
+        Alloc::ResetCounters();
+        dst = shorter;
+        assert(dst.Size() == SMALL && dst.Capacity() == LARGE);
+        assert(Alloc::num_allocations == 0);
+        assert(C::copy_assign == SMALL && C::copy_ctor == 0 && C::dtor == LARGE - SMALL);
+    }
+    for(const size_t dst_size : {SMALL, LARGE * 2}) {
+        // Перемещение забирает буфер независимо от размеров и освобождает прежний
+        CVector dst(dst_size);
+        CVector src(LARGE);
+        const C* src_data = src.begin();
+        C::Reset();
+        Alloc::ResetCounters();
+        dst = std::move(src);
+        assert(dst.Size() == LARGE && dst.begin() == src_data);
+        assert(src.Size() == 0 && src.Capacity() == 0);
+        assert(Alloc::num_allocations == 0 && Alloc::num_deallocations == 1);
+        assert(C::move_ctor == 0 && C::move_assign == 0 && C::copy_ctor == 0 && C::dtor == dst_size);
+    }
+    {
+        // Тривиально копируемые элементы на всех путях копирования
+        Vector<int> src(LARGE);
+        std::iota(src.begin(), src.end(), 0);
+        Vector<int> dst(SMALL);
+        dst = src;
+        assert(std::equal(dst.begin(), dst.end(), src.begin(), src.end()));
+        Vector<int> shorter(SMALL);
+        std::iota(shorter.begin(), shorter.end(), 100);
+        dst = shorter;
+        assert(std::equal(dst.begin(), dst.end(), shorter.begin(), shorter.end()));
+        dst = src;
+        assert(dst.Capacity() == LARGE && std::equal(dst.begin(), dst.end(), src.begin(), src.end()));
+    }
+    {
+        // Исключение при копировании в новый буфер не меняет вектор
+        Obj::ResetCounters();
+        Vector<Obj> dst(SMALL);
+        dst[0].id = 42;
+        Vector<Obj> src(LARGE);
+        src[LARGE - 1].throw_on_copy = true;
+        try {
+            dst = src;
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(dst.Size() == SMALL && dst.Capacity() == SMALL && dst[0].id == 42);
+        assert(Obj::GetAliveObjectCount() == SMALL + LARGE);
+    }
+}
+
+// Вектор с копированием при записи и публикация его версий
+void Test31() {
+    const size_t SIZE = 10;
+    {
+        CowVector<C> table{Vector<C>(SIZE)};
+        C::Reset();
+        CowVector<C> copy = table;
+        assert(copy.begin() == table.begin() && table.UseCount() == 2 && copy.IsShared());
+        assert(C::copy_ctor == 0);
+
+        // Первое изменение копирует элементы один раз, следующие — нет
+        copy.EmplaceBack();
+        assert(C::copy_ctor == SIZE && copy.Size() == SIZE + 1 && table.Size() == SIZE);
+        assert(!copy.IsShared() && !table.IsShared() && copy.begin() != table.begin());
+        copy.Set(0, C{});
+        copy.PopBack();
+        assert(C::copy_ctor == SIZE);
+
+        // Очистка разделённого вектора не копирует его
+        CowVector<C> cleared = table;
+        cleared.Clear();
+        assert(cleared.Empty() && table.Size() == SIZE && table.UseCount() == 1 && C::copy_ctor == SIZE);
+
+        CowVector<C> moved = std::move(copy);
+        assert(moved.Size() == SIZE && copy.Empty() && copy.UseCount() == 0);
+        copy = moved;
+        assert(moved.UseCount() == 2);
+    }
+    {
+        const CowVector<std::string> empty;
+        assert(empty.Empty() && empty.begin() == empty.end() && empty.View().Size() == 0);
+
+        AtomicCowVector<std::string> slot;
+        assert(slot.Acquire().Empty());
+        CowVector<std::string> routes;
+        routes.PushBack("a");
+        routes.PushBack("b");
+        slot.Publish(routes);
+        const CowVector<std::string> snapshot = slot.Acquire();
+        assert(snapshot.begin() == routes.begin() && routes.UseCount() == 3);
+
+        // Читатель продолжает пользоваться прежней версией после публикации следующей
+        routes.Set(0, "c");
+        slot.Publish(std::move(routes));
+        assert(snapshot[0] == "a" && snapshot.UseCount() == 1);
+        const CowVector<std::string> latest = slot.Acquire();
+        assert(latest[0] == "c" && latest.UseCount() == 2);
+    }
+    {
+        // Читатели получают целостные версии, пока писатель публикует новые
+        const int VERSIONS = 2000;
+        const int NUM_READERS = 4;
+        AtomicCowVector<int> slot{CowVector<int>{Vector<int>(SIZE)}};
+        std::atomic<bool> done{false};
+        std::atomic<int> num_acquired{0};
+        std::vector<std::thread> readers;
+        for(int i = 0; i < NUM_READERS; ++i) {
+            readers.emplace_back([&] {
+                int last_version = 0;
+                while(!done.load()) {
+                    const CowVector<int> version = slot.Acquire();
+                    assert(version.Size() == SIZE);
+                    assert(std::all_of(version.begin(), version.end(), [&](int value) {
+                        return value == version[0];
+                    }));
+                    assert(version[0] >= last_version);
+                    last_version = version[0];
+                    ++num_acquired;
+                }
+            });
+        }
+        CowVector<int> table = slot.Acquire();
+        for(int version = 1; version <= VERSIONS; ++version) {
+            Vector<int>& values = table.Edit();
+            std::fill(values.begin(), values.end(), version);
+            slot.Publish(table);
+            // Половина версий публикуется только после того, как читатели начали работу,
+            // иначе на одном ядре писатель может успеть закончить до их запуска
+            if(version == VERSIONS / 2) {
+                while(num_acquired.load() == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        done = true;
+        for(auto& reader : readers) {
+            reader.join();
+        }
+        assert(slot.Acquire()[SIZE - 1] == VERSIONS && num_acquired > 0);
+    }
+}
+
+void Test32() {
+    // 1000 элементов помещаются в два уровня дерева, 40000 — в три
+    for(const int size : {1000, 40000}) {
+        Vector<int> elements;
+        for(int i = 0; i < size; ++i) {
+            elements.PushBack(i);
+        }
+        const PersistentVector<int> base(elements);
+        assert(base.Size() == static_cast<size_t>(size));
+        assert(std::equal(base.begin(), base.end(), elements.begin(), elements.end()));
+        const Vector<int> round_trip = base.ToVector();
+        assert(std::equal(round_trip.begin(), round_trip.end(), elements.begin(), elements.end()));
+
+        // Новые версии не меняют прежние
+        const PersistentVector<int> changed = base.Set(7, -1).Set(size - 1, -2);
+        assert(changed[7] == -1 && changed[size - 1] == -2 && base[7] == 7 && base[size - 1] == size - 1);
+
+        // Удаление проходит через границы листов и уровней дерева
+        PersistentVector<int> shrinking = base;
+        for(int i = size; i > 0; --i) {
+            assert(shrinking.Size() == static_cast<size_t>(i) && shrinking.Back() == i - 1);
+            shrinking = shrinking.PopBack();
+        }
+        assert(shrinking.Empty() && shrinking.begin() == shrinking.end());
+        assert(base.Size() == static_cast<size_t>(size) && base[size / 2] == size / 2);
+
+        PersistentVector<int> growing;
+        for(int i = 0; i < size; ++i) {
+            growing = growing.PushBack(i);
+        }
+        assert(std::equal(growing.begin(), growing.end(), elements.begin(), elements.end()));
+    }
+    {
+        const size_t SIZE = 1000;
+        const size_t WIDTH = PersistentVector<C>::NODE_WIDTH;
+        PersistentVector<C>::Transient builder;
+        C::Reset();
+        for(size_t i = 0; i < SIZE; ++i) {
+            builder.PushBack(C{});
+        }
+        // Построитель владеет всеми узлами и не копирует элементы
+        assert(builder.Size() == SIZE && C::copy_ctor == 0);
+        const PersistentVector<C> base = std::move(builder).Persistent();
+
+        // Изменение элемента в дереве копирует один лист, а не все элементы
+        const PersistentVector<C> changed = base.Set(0, C{});
+        assert(C::copy_ctor == WIDTH);
+        C::Reset();
+        const PersistentVector<C> pushed = base.PushBack(C{});
+        assert(C::copy_ctor == SIZE % WIDTH && pushed.Size() == SIZE + 1 && base.Size() == SIZE);
+
+        // Построитель из версии копирует только разделённые узлы и только один раз
+        C::Reset();
+        PersistentVector<C>::Transient edit = changed.AsTransient();
+        edit.Set(1, C{});
+        edit.Set(2, C{});
+        assert(C::copy_ctor == WIDTH);
+        const PersistentVector<C> snapshot = edit.Persistent();
+        edit.Set(3, C{});
+        assert(C::copy_ctor == 2 * WIDTH);
+        assert(&snapshot[3] != &edit[3] && &snapshot[WIDTH] == &edit[WIDTH] && &snapshot[WIDTH] == &base[WIDTH]);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            PersistentVector<Obj> base;
+            for(int i = 0; i < 100; ++i) {
+                base = base.PushBack(Obj{});
+            }
+            Vector<PersistentVector<Obj>> history;
+            for(int i = 0; i < 100; ++i) {
+                history.PushBack(history.Size() == 0 ? base.PopBack() : history[history.Size() - 1].Set(i - 1, Obj{}));
+            }
+        }
+        // Узлы, разделённые версиями, освобождаются вместе с последней из них
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        // Если копирование элемента выбросит исключение, построенные узлы освобождаются
+        Vector<Obj> elements(200);
+        elements[100].throw_on_copy = true;
+        try {
+            PersistentVector<Obj> partial(elements);
+            assert(false);
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 200);
+    }
+}
+
+void Test33() {
+    // Размер хранится в наименьшем подходящем типе
+    static_assert(sizeof(StaticVector<char, 15>) == 16);
+    static_assert(sizeof(StaticVector<uint16_t, 300>) == 602);
+    static_assert(std::is_same_v<StaticVector<int, 70000>::size_type, uint32_t>);
+    static_assert(std::is_trivially_copyable_v<StaticVector<int, 8>>);
+    {
+        // Таблица строится при компиляции
+        constexpr auto squares = [] {
+            StaticVector<int, 16> table;
+            for(int i = 0; i < 10; ++i) {
+                table.PushBack(i * i);
+            }
+            table.Insert(table.begin(), -1);
+            table.Insert(table.begin() + 2, table[1]);
+            table.Erase(table.begin());
+            table.Erase(table.begin() + 1, table.begin() + 3);
+            table.EmplaceBack(100);
+            table.PopBack();
+            return table;
+        }();
+        static_assert(squares.Size() == 9 && squares[0] == 0 && squares[1] == 4 && squares[8] == 81);
+        static_assert(StaticVector<int, 4>(3).Size() == 3);
+
+        StaticVector<int, 16> copy = squares;
+        copy.Resize(16);
+        assert(copy[15] == 0 && squares.Size() == 9);
+        try {
+            copy.PushBack(1);
+            assert(false);
+        } catch (const std::length_error&) {
+        }
+        assert(copy.Size() == 16);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            StaticVector<Obj, 4> objects;
+            objects.EmplaceBack();
+            objects.PushBack(Obj{});
+            objects.Insert(objects.begin(), objects[1]);
+            assert(objects.Size() == 3 && Obj::GetAliveObjectCount() == 3);
+            objects.Erase(objects.begin() + 1);
+            StaticVector<Obj, 4> copy = objects;
+            StaticVector<Obj, 4> moved = std::move(copy);
+            assert(moved.Size() == 2 && copy.Empty() && Obj::GetAliveObjectCount() == 4);
+            objects = moved;
+            moved.Resize(4);
+            objects = std::move(moved);
+            assert(objects.Size() == 4 && moved.Empty() && Obj::GetAliveObjectCount() == 4);
+            objects.Resize(1);
+            assert(Obj::GetAliveObjectCount() == 1);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        StaticVector<std::string, 3> names;
+        names.PushBack("b");
+        names.Insert(names.begin(), "a");
+        names.Insert(names.begin(), names[1]);
+        assert(names[0] == "b" && names[1] == "a" && names[2] == "b");
+        try {
+            names.EmplaceBack("c");
+            assert(false);
+        } catch (const std::length_error&) {
+        }
+        assert(names.Size() == 3 && names[2] == "b");
+    }
+    {
+        // Неприсваиваемые типы хранятся в буфере и создаются на месте
+        struct Fixed {
+            const int value = 0;
+        };
+        static_assert(!static_vector_detail::IS_CONSTEXPR_STORAGE<Fixed>);
+        static_assert(!static_vector_detail::IS_CONSTEXPR_STORAGE<std::atomic<int>>);
+        StaticVector<Fixed, 4> fixed;
+        fixed.EmplaceBack(Fixed{7});
+        fixed.EmplaceBack();
+        fixed.PopBack();
+        assert(fixed.Size() == 1 && fixed[0].value == 7);
+        StaticVector<std::atomic<int>, 2> counters;
+        counters.EmplaceBack(1);
+        counters.EmplaceBack(2);
+        counters[0].fetch_add(10);
+        counters.Resize(1);
+        assert(counters.Size() == 1 && counters[0].load() == 11);
+    }
+}
+
+void Test34() {
+    static_assert(sizeof(CompactVector<int>) == sizeof(void*));
+    static_assert(sizeof(CompactVector<std::string>) == sizeof(void*));
+    {
+        using Alloc = CountingAllocator<std::string>;
+        Alloc::ResetCounters();
+        Vector<CompactVector<std::string, Alloc>> index(1000);
+        assert(Alloc::num_allocations == 0 && index[0].Empty() && index[0].begin() == index[0].end());
+
+        CompactVector<std::string, Alloc>& names = index[0];
+        names.PushBack("b");
+        names.Insert(names.begin(), "a");
+        names.Insert(names.begin(), names[1]);
+        names.EmplaceBack(3, 'c');
+        assert(names.Size() == 4 && names[0] == "b" && names[1] == "a" && names[2] == "b" && names[3] == "ccc");
+        names.Erase(names.begin());
+        names.Erase(names.begin() + 1, names.end());
+        assert(names.Size() == 1 && names[0] == "a");
+
+        CompactVector<std::string, Alloc> copy = names;
+        copy.Resize(5);
+        index[1] = copy;
+        index[2] = std::move(copy);
+        assert(index[1].Size() == 5 && index[2].Size() == 5 && copy.Empty() && copy.Capacity() == 0);
+        index[1] = names;
+        assert(index[1].Size() == 1 && index[1][0] == "a" && index[1].Capacity() == 5);
+        index[1].Clear();
+        index[1].ShrinkToFit();
+        assert(index[1].Capacity() == 0);
+        index[2].Swap(index[3]);
+        assert(index[2].Empty() && index[3].Size() == 5);
+    }
+    using StringUnits = compact_vector_detail::UnitAllocator<std::string, CountingAllocator<std::string>>;
+    assert(StringUnits::num_allocations != 0 && StringUnits::num_allocations == StringUnits::num_deallocations);
+    {
+        // Исключение из конструктора элемента не оставляет неосвобождённых блоков
+        using Alloc = CountingAllocator<Obj>;
+        using ObjUnits = compact_vector_detail::UnitAllocator<Obj, Alloc>;
+        ObjUnits::ResetCounters();
+        Obj::ResetCounters();
+        {
+            Obj::default_construction_throw_countdown = 5;
+            try {
+                CompactVector<Obj, Alloc> objects(10);
+                assert(false);
+            } catch (const std::runtime_error&) {
+            }
+            CompactVector<Obj, Alloc> small(1);
+            CompactVector<Obj, Alloc> source(3);
+            source[2].throw_on_copy = true;
+            try {
+                small = source;
+                assert(false);
+            } catch (const std::runtime_error&) {
+            }
+            try {
+                CompactVector<Obj, Alloc> copy(source);
+                assert(false);
+            } catch (const std::runtime_error&) {
+            }
+            assert(small.Size() == 1 && Obj::GetAliveObjectCount() == 4);
+        }
+        assert(ObjUnits::num_allocations == ObjUnits::num_deallocations && Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            CompactVector<Obj> objects(3);
+            objects.Reserve(10);
+            objects.PopBack();
+            objects.ShrinkToFit();
+            assert(objects.Capacity() == 2 && Obj::GetAliveObjectCount() == 2);
+            try {
+                objects.Reserve(size_t{UINT32_MAX} + 1);
+                assert(false);
+            } catch (const std::length_error&) {
+            }
+            assert(objects.Size() == 2);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        // Элементы со строгим выравниванием начинаются на его границе
+        struct alignas(32) Wide {
+            char bytes[32];
+        };
+        CompactVector<Wide> wide(2);
+        assert(reinterpret_cast<uintptr_t>(wide.begin()) % 32 == 0);
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Выполняет action в дочернем процессе и проверяет, что нарушение проверки Vector
+// завершило его через std::abort
+template <typename Action>
+void ExpectCheckFailure(Action action) {
+    const pid_t pid = fork();
+    assert(pid >= 0);
+    if(pid == 0) {
+        SetVectorCheckHandler([](const char* /*message*/) {
+        });
+        action();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+}
+#endif
+
+void Test35() {
+    using Bounds = Vector<int, std::allocator<int>, DoublingGrowth, NoVectorStats, BoundsVectorChecks>;
+    using Debug = Vector<int, std::allocator<int>, DoublingGrowth, NoVectorStats, DebugVectorChecks>;
+    // Проверка границ не меняет ни размер вектора, ни тип итераторов
+    static_assert(sizeof(Bounds) == sizeof(Vector<int>) && std::is_same_v<Bounds::iterator, int*>);
+    static_assert(sizeof(Debug) == sizeof(Vector<int>) + sizeof(uint64_t));
+    static_assert(std::is_convertible_v<Debug::iterator, Debug::const_iterator>);
+    {
+        // С проверками вектор ведёт себя как обычно
+        Debug v;
+        for(int i = 10; i > 0; --i) {
+            v.PushBack(i);
+        }
+        std::sort(v.begin(), v.end());
+        assert(v[0] == 1 && *(v.end() - 1) == 10 && v.end() - v.begin() == 10);
+        v.Insert(v.begin() + 2, 100);
+        v.Insert(v.cend(), 2, 200);
+        v.Erase(v.begin(), v.begin() + 2);
+        v.SwapErase(v.cbegin());
+        assert(EraseIf(v, [](int value) { return value > 100; }) == 2);
+        assert(v.Size() == 8 && v[0] == 3 && Find(v, 5) - v.begin() == 2 && Sum(v) == 52);
+        Debug::const_iterator it = v.begin();
+        assert(it == v.cbegin() && it != v.end() && *std::next(it) == 4);
+        std::string text;
+        for(const int value : v) {
+            text += std::to_string(value);
+        }
+        assert(text == "345678910");
+        Bounds bounds(3);
+        bounds.Emplace(bounds.begin() + 3, 7);
+        assert(bounds[3] == 7);
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    ExpectCheckFailure([] {
+        Bounds v(3);
+        [[maybe_unused]] volatile int value = v[3];
+    });
+    ExpectCheckFailure([] {
+        Bounds v;
+        v.PopBack();
+    });
+    ExpectCheckFailure([] {
+        Bounds v(3);
+        v.Erase(v.end());
+    });
+    ExpectCheckFailure([] {
+        Bounds v(3);
+        v.Insert(v.begin() + 4, 1);
+    });
+    // Итератор устаревает при смене буфера
+    ExpectCheckFailure([] {
+        Debug v(3);
+        Debug::iterator it = v.begin();
+        v.Reserve(100);
+        [[maybe_unused]] volatile int value = *it;
+    });
+    ExpectCheckFailure([] {
+        Debug v(3);
+        Debug::iterator it = v.begin();
+        Debug other(std::move(v));
+        [[maybe_unused]] volatile bool equal = it == other.begin();
+    });
+    ExpectCheckFailure([] {
+        Debug v(3);
+        Debug other(3);
+        v.Insert(other.begin(), 1);
+    });
+    ExpectCheckFailure([] {
+        Debug v(3);
+        Debug::iterator it = v.end();
+        ++it;
+    });
+    ExpectCheckFailure([] {
+        Debug v(3);
+        [[maybe_unused]] volatile int value = *v.end();
+    });
+#endif
+}
+
+#if defined(__cpp_impl_coroutine)
+// Источник, отдающий заранее заданные порции байт. Каждое чтение приостанавливает
+// корутину до вызова Complete, как это делает настоящий асинхронный ввод
+class ChunkedReader {
+public:
+    explicit ChunkedReader(std::vector<std::string> chunks) : chunks_(std::move(chunks)) {
+    }
+
+    auto ReadSome(void* data, size_t size) {
+        struct Awaiter {
+            bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                reader.pending_ = handle;
+            }
+
+            size_t await_resume() const {
+                if(reader.next_ == reader.chunks_.size()) {
+                    return 0;
+                }
+                const std::string& chunk = reader.chunks_[reader.next_++];
+                if(chunk == "error") {
+                    throw std::runtime_error("read failed");
+                }
+                assert(chunk.size() <= size);
+                std::memcpy(data, chunk.data(), chunk.size());
+                return chunk.size();
+            }
+
+            ChunkedReader& reader;
+            void* data;
+            size_t size;
+        };
+        ++reads_;
+        return Awaiter{*this, data, size};
+    }
+
+    // Завершает ожидающее чтение. Возвращает false, если ожидающих чтений нет
+    bool Complete() {
+        if(!pending_) {
+            return false;
+        }
+        std::exchange(pending_, nullptr).resume();
+        return true;
+    }
+
+    int Reads() const noexcept {
+        return reads_;
+    }
+
+private:
+    std::vector<std::string> chunks_;
+    size_t next_ = 0;
+    int reads_ = 0;
+    std::coroutine_handle<> pending_;
+};
+
+// Корутина, запускаемая сразу и не ожидающая завершения
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() noexcept {
+        }
+
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+template <typename VectorType>
+DetachedTask AppendAll(VectorType& v, ChunkedReader& reader, size_t max_count, std::vector<size_t>& counts,
+                       std::string& error) {
+    try {
+        for(;;) {
+            const size_t count = co_await AppendFrom(v, reader, max_count);
+            counts.push_back(count);
+            if(count == 0) {
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+}
+
+template <typename T>
+std::string Bytes(std::initializer_list<T> values) {
+    std::string bytes(values.size() * sizeof(T), '\0');
+    std::memcpy(bytes.data(), values.begin(), bytes.size());
+    return bytes;
+}
+#endif
+
+void Test36() {
+    struct Record {
+        uint32_t id;
+        uint16_t kind;
+        uint16_t flags;
+        uint64_t payload;
+    };
+    // Элементы пишутся прямо в свободную ёмкость
+    {
+        Vector<int> v;
+        v.Reserve(8);
+        v.PushBack(1);
+        int* spare = v.SpareCapacity();
+        spare[0] = 2;
+        spare[1] = 3;
+        v.CommitAppend(2);
+        assert(v.Size() == 3 && v[1] == 2 && v[2] == 3 && v.Capacity() == 8);
+        v.CommitAppend(0);
+        assert(v.Size() == 3);
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    const auto make_record = [](uint32_t i) {
+        return Record{i, static_cast<uint16_t>(i % 7), static_cast<uint16_t>(i * 3), i * 1000003ull};
+    };
+    // Запись порциями, разрывающими элементы, восстанавливается целиком
+    {
+        constexpr uint32_t COUNT = 5000;
+        int fds[2];
+        [[maybe_unused]] const int piped = pipe(fds);
+        assert(piped == 0);
+        std::thread writer([&] {
+            std::vector<Record> records;
+            for(uint32_t i = 0; i < COUNT; ++i) {
+                records.push_back(make_record(i));
+            }
+            const char* bytes = reinterpret_cast<const char*>(records.data());
+            const size_t total = records.size() * sizeof(Record);
+            for(size_t offset = 0, chunk = 1; offset < total; chunk = chunk * 7 % 1021 + 1) {
+                const ssize_t written = write(fds[1], bytes + offset, std::min(chunk, total - offset));
+                assert(written > 0);
+                offset += written;
+            }
+            close(fds[1]);
+        });
+        Vector<Record> v;
+        size_t calls = 0;
+        for(size_t count; (count = AppendFrom(v, fds[0], 1000)) != 0; ++calls) {
+            assert(count <= 1000);
+        }
+        writer.join();
+        close(fds[0]);
+        assert(v.Size() == COUNT && calls >= COUNT / 1000);
+        for(uint32_t i = 0; i < COUNT; ++i) {
+            const Record expected = make_record(i);
+            assert(v[i].id == expected.id && v[i].kind == expected.kind && v[i].flags == expected.flags
+                   && v[i].payload == expected.payload);
+        }
+    }
+    // Поток оборвался посреди элемента: полный элемент уже в векторе
+    {
+        int fds[2];
+        [[maybe_unused]] const int piped = pipe(fds);
+        assert(piped == 0);
+        const Record records[2] = {make_record(1), make_record(2)};
+        [[maybe_unused]] const ssize_t written = write(fds[1], records, sizeof(Record) * 3 / 2);
+        assert(written == static_cast<ssize_t>(sizeof(Record) * 3 / 2));
+        close(fds[1]);
+        Vector<Record> v;
+        size_t received = 0;
+        try {
+            while(AppendFrom(v, fds[0], 10) != 0) {
+            }
+            assert(false);
+        } catch (const VectorReadError&) {
+            ++received;
+        }
+        close(fds[0]);
+        assert(received == 1 && v.Size() == 1 && v[0].id == 1 && v[0].payload == make_record(1).payload);
+    }
+    // Неблокирующий дескриптор ждёт данных, а не возвращает пустой результат
+    {
+        int fds[2];
+        [[maybe_unused]] const int piped = pipe(fds);
+        [[maybe_unused]] const int flagged = fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        assert(piped == 0 && flagged == 0);
+        std::thread writer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const uint64_t values[3] = {7, 8, 9};
+            [[maybe_unused]] const ssize_t written = write(fds[1], values, sizeof(values));
+            assert(written == static_cast<ssize_t>(sizeof(values)));
+            close(fds[1]);
+        });
+        Vector<uint64_t> v;
+        size_t total = 0;
+        for(size_t count; (count = AppendFrom(v, fds[0], 16)) != 0;) {
+            total += count;
+        }
+        writer.join();
+        close(fds[0]);
+        assert(total == 3 && v.Size() == 3 && v[0] == 7 && v[2] == 9);
+    }
+    // Количество, не помещающееся в размер в байтах, и закрытый дескриптор сообщаются исключениями
+    {
+        Vector<uint64_t> v(1);
+        try {
+            AppendFrom(v, -1, SIZE_MAX / sizeof(uint64_t));
+            assert(false);
+        } catch (const std::length_error&) {
+        }
+        try {
+            AppendFrom(v, -1, 4);
+            assert(false);
+        } catch (const std::system_error& e) {
+            assert(e.code().value() == EBADF);
+        }
+        assert(v.Size() == 1);
+    }
+    // Резерв растёт по политике вектора, а не ровно на запрошенное количество
+    {
+        int fds[2];
+        [[maybe_unused]] const int piped = pipe(fds);
+        assert(piped == 0);
+        const uint32_t values[64] = {};
+        [[maybe_unused]] const ssize_t written = write(fds[1], values, sizeof(values));
+        assert(written == static_cast<ssize_t>(sizeof(values)));
+        close(fds[1]);
+        Vector<uint32_t, std::allocator<uint32_t>, DoublingGrowth> v;
+        size_t buffers = 0;
+        for(const uint32_t* data = nullptr; AppendFrom(v, fds[0], 3) != 0;) {
+            if(v.Data() != data) {
+                data = v.Data();
+                ++buffers;
+            }
+        }
+        close(fds[0]);
+        assert(v.Size() == 64 && buffers <= 7);
+    }
+#endif
+#if defined(__cpp_impl_coroutine)
+    {
+        // Порции разрывают элементы; каждое ожидание завершается извне
+        ChunkedReader reader({Bytes<uint32_t>({1, 2}).substr(0, 6), Bytes<uint32_t>({1, 2}).substr(6),
+                              Bytes<uint32_t>({3, 4, 5}), Bytes<uint32_t>({6}).substr(0, 1),
+                              Bytes<uint32_t>({6}).substr(1)});
+        Vector<uint32_t> v;
+        std::vector<size_t> counts;
+        std::string error;
+        AppendAll(v, reader, 4, counts, error);
+        assert(v.Size() == 0 && counts.empty());
+        while(reader.Complete()) {
+        }
+        assert(error.empty() && v.Size() == 6 && counts == std::vector<size_t>({2, 3, 1, 0}));
+        for(uint32_t i = 0; i < 6; ++i) {
+            assert(v[i] == i + 1);
+        }
+        assert(reader.Reads() == 6);
+    }
+    {
+        // Обрыв посреди элемента и ошибка источника не теряют полученные элементы
+        ChunkedReader truncated({Bytes<uint64_t>({10, 11}).substr(0, 12)});
+        Vector<uint64_t> v;
+        std::vector<size_t> counts;
+        std::string error;
+        AppendAll(v, truncated, 8, counts, error);
+        while(truncated.Complete()) {
+        }
+        assert(counts.empty() && error == "Stream ended inside an element" && v.Size() == 1 && v[0] == 10);
+
+        ChunkedReader failing({Bytes<uint64_t>({12, 13}).substr(0, 10), "error"});
+        AppendAll(v, failing, 8, counts, error);
+        while(failing.Complete()) {
         }
-        Dump();
-    } catch (...) {
+        assert(counts.empty() && error == "read failed" && v.Size() == 2 && v[1] == 12);
     }
+#endif
 }
 
 int main() {
@@ -647,7 +3054,36 @@ int main() {
         Test4();
         Test5();
         Test6();
-        Benchmark();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
+        Test34();
+        Test35();
+        Test36();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
     }
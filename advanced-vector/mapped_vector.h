@@ -0,0 +1,281 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Способ открытия файла MappedVector
+enum class MapMode {
+    // Создаёт пустой файл или обнуляет существующий
+    CREATE,
+    // Открывает существующий файл для чтения и изменения
+    READ_WRITE,
+    // Открывает существующий файл только для чтения
+    READ_ONLY,
+};
+
+// Вектор тривиально копируемых записей, хранящихся в отображённом в память файле.
+// Файл содержит ровно Size() записей подряд без заголовка, поэтому открытие готового
+// массива записей не читает и не копирует его: страницы подгружаются ядром при
+// обращении. При росте файл удлиняется через ftruncate до новой ёмкости и отображается
+// заново, а при закрытии укорачивается до размера вектора.
+// Изменения попадают в файл через общее отображение, Flush дожидается их записи на диск.
+// Рост перемещает отображение, поэтому указатели на элементы после него недействительны
+template <typename T, typename Growth = DoublingGrowth>
+class MappedVector {
+    static_assert(std::is_trivially_copyable_v<T>, "MappedVector stores raw records and requires trivially copyable T");
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+    using growth_policy = Growth;
+
+    MappedVector(const std::string& path, MapMode mode) : read_only_(mode == MapMode::READ_ONLY) {
+        int flags = O_RDWR;
+        if(mode == MapMode::CREATE) {
+            flags |= O_CREAT | O_TRUNC;
+        } else if(mode == MapMode::READ_ONLY) {
+            flags = O_RDONLY;
+        }
+        fd_ = open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if(fd_ < 0) {
+            ThrowSystemError("cannot open " + path);
+        }
+        struct stat file_stat {};
+        if(fstat(fd_, &file_stat) != 0) {
+            const int error = errno;
+            close(fd_);
+            ThrowSystemError("cannot stat " + path, error);
+        }
+        const size_t file_size = static_cast<size_t>(file_stat.st_size);
+        if(file_size % sizeof(T) != 0) {
+            close(fd_);
+            throw std::runtime_error(path + " is not a whole number of records");
+        }
+        size_ = capacity_ = file_size / sizeof(T);
+        try {
+            Map();
+        } catch (...) {
+            close(fd_);
+            throw;
+        }
+    }
+
+    MappedVector(const MappedVector&) = delete;
+    MappedVector& operator=(const MappedVector&) = delete;
+
+    MappedVector(MappedVector&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , capacity_(std::exchange(other.capacity_, 0))
+        , fd_(std::exchange(other.fd_, -1))
+        , read_only_(other.read_only_) {
+    }
+
+    MappedVector& operator=(MappedVector&& rhs) noexcept {
+        if(this != &rhs) {
+            Close();
+            data_ = std::exchange(rhs.data_, nullptr);
+            size_ = std::exchange(rhs.size_, 0);
+            capacity_ = std::exchange(rhs.capacity_, 0);
+            fd_ = std::exchange(rhs.fd_, -1);
+            read_only_ = rhs.read_only_;
+        }
+        return *this;
+    }
+
+    ~MappedVector() {
+        Close();
+    }
+
+    bool IsReadOnly() const noexcept {
+        return read_only_;
+    }
+
+    // Удлиняет файл до new_capacity записей
+    void Reserve(size_t new_capacity) {
+        RequireWritable();
+        if(new_capacity <= capacity_) {
+            return;
+        }
+        Remap(new_capacity);
+    }
+
+    // Новые записи инициализируются значением
+    void Resize(size_t new_size) {
+        RequireWritable();
+        Reserve(new_size);
+        if(new_size > size_) {
+            std::uninitialized_value_construct_n(data_ + size_, new_size - size_);
+        }
+        size_ = new_size;
+    }
+
+    void Clear() {
+        RequireWritable();
+        size_ = 0;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        RequireWritable();
+        // Аргументы могут ссылаться на записи, которые переедут при росте
+        const T value(std::forward<Args>(args)...);
+        if(size_ == capacity_) {
+            Remap(Growth::NextCapacity(capacity_, size_ + 1, sizeof(T)));
+        }
+        std::memcpy(static_cast<void*>(data_ + size_), &value, sizeof(T));
+        return data_[size_++];
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PopBack() {
+        RequireWritable();
+        assert(size_ > 0);
+        --size_;
+    }
+
+    // Дожидается записи изменённых страниц на диск
+    void Flush() {
+        if(data_ != nullptr && !read_only_ && msync(data_, capacity_ * sizeof(T), MS_SYNC) != 0) {
+            ThrowSystemError("msync failed");
+        }
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return capacity_;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+    // Запись в вектор, открытый только для чтения, завершит программу сигналом SIGSEGV
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return data_[index];
+    }
+
+    iterator begin() noexcept {
+        return data_;
+    }
+
+    iterator end() noexcept {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return data_;
+    }
+
+    const_iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+private:
+    [[noreturn]] static void ThrowSystemError(const std::string& what, int error = errno) {
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    void RequireWritable() const {
+        if(read_only_) {
+            throw std::logic_error("MappedVector is read-only");
+        }
+    }
+
+    void Map() {
+        if(capacity_ == 0) {
+            data_ = nullptr;
+            return;
+        }
+        const int protection = read_only_ ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* ptr = mmap(nullptr, capacity_ * sizeof(T), protection, MAP_SHARED, fd_, 0);
+        if(ptr == MAP_FAILED) {
+            ThrowSystemError("mmap failed");
+        }
+        data_ = static_cast<T*>(ptr);
+    }
+
+    // Удлиняет файл и отображение до new_capacity записей. При ошибке вектор не меняется
+    void Remap(size_t new_capacity) {
+        if(new_capacity > static_cast<size_t>(std::numeric_limits<off_t>::max()) / sizeof(T)) {
+            throw std::length_error("MappedVector is too large");
+        }
+        const size_t new_bytes = new_capacity * sizeof(T);
+        if(ftruncate(fd_, static_cast<off_t>(new_bytes)) != 0) {
+            ThrowSystemError("ftruncate failed");
+        }
+#if defined(__linux__)
+        void* ptr = data_ != nullptr ? mremap(data_, capacity_ * sizeof(T), new_bytes, MREMAP_MAYMOVE)
+                                     : mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+#else
+        void* ptr = mmap(nullptr, new_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+#endif
+        if(ptr == MAP_FAILED) {
+            const int error = errno;
+            // Если вернуть прежнюю длину не удалось, лишние записи отрежет Close
+            [[maybe_unused]] const int truncated = ftruncate(fd_, static_cast<off_t>(capacity_ * sizeof(T)));
+            ThrowSystemError("cannot remap file", error);
+        }
+#if !defined(__linux__)
+        if(data_ != nullptr) {
+            munmap(data_, capacity_ * sizeof(T));
+        }
+#endif
+        data_ = static_cast<T*>(ptr);
+        capacity_ = new_capacity;
+    }
+
+    // Снимает отображение и укорачивает файл до размера вектора
+    void Close() noexcept {
+        if(data_ != nullptr) {
+            munmap(data_, capacity_ * sizeof(T));
+            data_ = nullptr;
+        }
+        if(fd_ >= 0) {
+            if(!read_only_) {
+                // Ошибку в деструкторе сообщить некому, при неудаче файл сохранит лишнюю ёмкость
+                [[maybe_unused]] const int truncated = ftruncate(fd_, static_cast<off_t>(size_ * sizeof(T)));
+            }
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    int fd_ = -1;
+    bool read_only_ = false;
+};
+#endif
@@ -0,0 +1,488 @@
+#pragma once
+#include "vector.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+// Неизменяемый вектор со структурным разделением. Элементы хранятся в листьях
+// 32-ричного префиксного дерева, а последние до 32 элементов — в отдельном листе-хвосте.
+// Set, PushBack и PopBack не меняют вектор, а возвращают новую версию за O(log32 n):
+// копируются только узлы на пути к изменённому элементу, остальные разделяются со
+// старой версией. Узлы освобождаются по счётчику ссылок, так что версии можно передавать
+// в другие потоки.
+// Для серии изменений служит Transient: узлы, на которые нет других ссылок, он изменяет
+// на месте, и копирует только узлы, разделённые с другими версиями
+template <typename T>
+class PersistentVector {
+    static constexpr unsigned BITS = 5;
+    static constexpr size_t WIDTH = size_t{1} << BITS;
+    static constexpr size_t MASK = WIDTH - 1;
+
+    struct Node {
+        std::atomic<size_t> refs{1};
+    };
+
+    struct Branch : Node {
+        Node* children[WIDTH] = {};
+    };
+
+    struct Leaf : Node {
+        // Элементы хранилища не инициализируются
+        Leaf() noexcept {
+        }
+
+        Leaf(const Leaf&) = delete;
+        Leaf& operator=(const Leaf&) = delete;
+
+        ~Leaf() {
+            DestroyN(Elements(), count);
+        }
+
+        T* Elements() noexcept {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+
+        size_t count = 0;
+        alignas(T) unsigned char storage[WIDTH * sizeof(T)];
+    };
+
+public:
+    class Transient;
+    class const_iterator;
+
+    using value_type = T;
+    using iterator = const_iterator;
+
+    static constexpr size_t NODE_WIDTH = WIDTH;
+
+    PersistentVector() = default;
+
+    // Если копирование элемента выбросит исключение, построенные узлы освободит деструктор
+    explicit PersistentVector(const Vector<T>& elements) : PersistentVector() {
+        for(const T& value : elements) {
+            PushBackInPlace(value);
+        }
+    }
+
+    PersistentVector(const PersistentVector& other) noexcept
+        : root_(Retain(other.root_))
+        , tail_(Retain(other.tail_))
+        , size_(other.size_)
+        , shift_(other.shift_) {
+    }
+
+    PersistentVector(PersistentVector&& other) noexcept
+        : root_(std::exchange(other.root_, nullptr))
+        , tail_(std::exchange(other.tail_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , shift_(std::exchange(other.shift_, BITS)) {
+    }
+
+    PersistentVector& operator=(const PersistentVector& rhs) noexcept {
+        PersistentVector rhs_copy(rhs);
+        Swap(rhs_copy);
+        return *this;
+    }
+
+    PersistentVector& operator=(PersistentVector&& rhs) noexcept {
+        if(this != &rhs) {
+            PersistentVector old(std::move(*this));
+            Swap(rhs);
+        }
+        return *this;
+    }
+
+    ~PersistentVector() {
+        Release(root_, shift_);
+        Release(tail_, 0);
+    }
+
+    void Swap(PersistentVector& other) noexcept {
+        std::swap(root_, other.root_);
+        std::swap(tail_, other.tail_);
+        std::swap(size_, other.size_);
+        std::swap(shift_, other.shift_);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    bool Empty() const noexcept {
+        return size_ == 0;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return ChunkFor(index)[index & MASK];
+    }
+
+    const T& Back() const noexcept {
+        return (*this)[size_ - 1];
+    }
+
+    // Новая версия, в которой элемент index равен value
+    [[nodiscard]] PersistentVector Set(size_t index, T value) const {
+        PersistentVector result(*this);
+        result.SetInPlace(index, std::move(value));
+        return result;
+    }
+
+    [[nodiscard]] PersistentVector PushBack(T value) const {
+        PersistentVector result(*this);
+        result.PushBackInPlace(std::move(value));
+        return result;
+    }
+
+    [[nodiscard]] PersistentVector PopBack() const {
+        PersistentVector result(*this);
+        result.PopBackInPlace();
+        return result;
+    }
+
+    Transient AsTransient() const {
+        return Transient(*this);
+    }
+
+    Vector<T> ToVector() const {
+        Vector<T> result;
+        result.Reserve(size_);
+        for(size_t first = 0; first < size_; first += WIDTH) {
+            const T* chunk = ChunkFor(first);
+            result.Insert(result.cend(), chunk, chunk + std::min(WIDTH, size_ - first));
+        }
+        return result;
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    // Изменяемый построитель версий. Версия, полученная Persistent(), разделяет с ним узлы,
+    // и последующие изменения построителя её не затрагивают
+    class Transient {
+    public:
+        Transient() = default;
+
+        explicit Transient(PersistentVector base) noexcept : vector_(std::move(base)) {
+        }
+
+        size_t Size() const noexcept {
+            return vector_.Size();
+        }
+
+        const T& operator[](size_t index) const noexcept {
+            return vector_[index];
+        }
+
+        void Set(size_t index, T value) {
+            vector_.SetInPlace(index, std::move(value));
+        }
+
+        void PushBack(T value) {
+            vector_.PushBackInPlace(std::move(value));
+        }
+
+        void PopBack() {
+            vector_.PopBackInPlace();
+        }
+
+        PersistentVector Persistent() const& noexcept {
+            return vector_;
+        }
+
+        PersistentVector Persistent() && noexcept {
+            return std::move(vector_);
+        }
+
+    private:
+        PersistentVector vector_;
+    };
+
+    // Итератор запоминает лист текущего элемента и спускается по дереву раз в 32 элемента
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator*() const noexcept {
+            return chunk_[index_ & MASK];
+        }
+
+        pointer operator->() const noexcept {
+            return &**this;
+        }
+
+        const_iterator& operator++() noexcept {
+            ++index_;
+            if((index_ & MASK) == 0 && index_ < vector_->size_) {
+                chunk_ = vector_->ChunkFor(index_);
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+    private:
+        friend class PersistentVector;
+
+        const_iterator(const PersistentVector* vector, size_t index) noexcept
+            : vector_(vector)
+            , index_(index)
+            , chunk_(index < vector->size_ ? vector->ChunkFor(index) : nullptr) {
+        }
+
+        const PersistentVector* vector_ = nullptr;
+        size_t index_ = 0;
+        const T* chunk_ = nullptr;
+    };
+
+private:
+    static Leaf* AsLeaf(Node* node) noexcept {
+        return static_cast<Leaf*>(node);
+    }
+
+    static Branch* AsBranch(Node* node) noexcept {
+        return static_cast<Branch*>(node);
+    }
+
+    static Node* Retain(Node* node) noexcept {
+        if(node != nullptr) {
+            node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    // Освобождает ссылку на узел уровня level. Уровень 0 — листья
+    static void Release(Node* node, unsigned level) noexcept {
+        if(node == nullptr || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        if(level == 0) {
+            delete AsLeaf(node);
+        } else {
+            for(Node* child : AsBranch(node)->children) {
+                Release(child, level - BITS);
+            }
+            delete AsBranch(node);
+        }
+    }
+
+    // Возвращает узел из slot, который можно изменять на месте. Узел, на который есть
+    // другие ссылки, заменяется в slot копией
+    static Leaf* EditableLeaf(Node*& slot) {
+        if(slot->refs.load(std::memory_order_acquire) == 1) {
+            return AsLeaf(slot);
+        }
+        auto copy = std::make_unique<Leaf>();
+        Leaf* source = AsLeaf(slot);
+        std::uninitialized_copy_n(source->Elements(), source->count, copy->Elements());
+        copy->count = source->count;
+        Release(std::exchange(slot, copy.get()), 0);
+        return copy.release();
+    }
+
+    static Branch* EditableBranch(Node*& slot, unsigned level) {
+        if(slot->refs.load(std::memory_order_acquire) == 1) {
+            return AsBranch(slot);
+        }
+        Branch* copy = new Branch;
+        for(size_t i = 0; i < WIDTH; ++i) {
+            copy->children[i] = Retain(AsBranch(slot)->children[i]);
+        }
+        Release(std::exchange(slot, copy), level);
+        return copy;
+    }
+
+    // Цепочка ветвей от уровня level до листа leaf. Ссылка на leaf передаётся цепочке
+    static Node* NewPath(unsigned level, Node* leaf) {
+        Node* path = leaf;
+        try {
+            for(unsigned current = BITS; current <= level; current += BITS) {
+                Branch* branch = new Branch;
+                branch->children[0] = path;
+                path = branch;
+            }
+        } catch (...) {
+            FreePath(path, leaf);
+            throw;
+        }
+        return path;
+    }
+
+    // Освобождает ветви цепочки NewPath, не освобождая её лист
+    static void FreePath(Node* path, Node* leaf) noexcept {
+        while(path != leaf) {
+            Branch* branch = AsBranch(path);
+            path = std::exchange(branch->children[0], nullptr);
+            delete branch;
+        }
+    }
+
+    size_t TailOffset() const noexcept {
+        return size_ < WIDTH ? 0 : ((size_ - 1) >> BITS) << BITS;
+    }
+
+    // Элементы листа, содержащего элемент index
+    const T* ChunkFor(size_t index) const noexcept {
+        if(index >= TailOffset()) {
+            return AsLeaf(tail_)->Elements();
+        }
+        Node* node = root_;
+        for(unsigned level = shift_; level > 0; level -= BITS) {
+            node = AsBranch(node)->children[(index >> level) & MASK];
+        }
+        return AsLeaf(node)->Elements();
+    }
+
+    void SetInPlace(size_t index, T value) {
+        assert(index < size_);
+        if(index >= TailOffset()) {
+            EditableLeaf(tail_)->Elements()[index & MASK] = std::move(value);
+            return;
+        }
+        Node** slot = &root_;
+        for(unsigned level = shift_; level > 0; level -= BITS) {
+            slot = &EditableBranch(*slot, level)->children[(index >> level) & MASK];
+        }
+        EditableLeaf(*slot)->Elements()[index & MASK] = std::move(value);
+    }
+
+    void PushBackInPlace(T value) {
+        if(size_ - TailOffset() < WIDTH || tail_ == nullptr) {
+            if(tail_ == nullptr) {
+                tail_ = new Leaf;
+            }
+            Leaf* tail = EditableLeaf(tail_);
+            new (tail->Elements() + tail->count) T(std::move(value));
+            ++tail->count;
+            ++size_;
+            return;
+        }
+        // Хвост заполнен: он переходит в дерево, а значение начинает новый хвост
+        auto new_tail = std::make_unique<Leaf>();
+        new (new_tail->Elements()) T(std::move(value));
+        new_tail->count = 1;
+        if(root_ == nullptr) {
+            root_ = NewPath(shift_, tail_);
+        } else if((size_ >> BITS) > (size_t{1} << shift_)) {
+            // Корень заполнен, дерево вырастает на уровень
+            Node* path = NewPath(shift_, tail_);
+            Branch* new_root;
+            try {
+                new_root = new Branch;
+            } catch (...) {
+                FreePath(path, tail_);
+                throw;
+            }
+            new_root->children[0] = root_;
+            new_root->children[1] = path;
+            root_ = new_root;
+            shift_ += BITS;
+        } else {
+            PushTail(shift_, root_);
+        }
+        tail_ = new_tail.release();
+        ++size_;
+    }
+
+    // Вставляет заполненный хвост в поддерево slot уровня level
+    void PushTail(unsigned level, Node*& slot) {
+        const size_t sub = ((size_ - 1) >> level) & MASK;
+        Branch* branch = EditableBranch(slot, level);
+        if(level == BITS) {
+            branch->children[sub] = tail_;
+        } else if(branch->children[sub] != nullptr) {
+            PushTail(level - BITS, branch->children[sub]);
+        } else {
+            branch->children[sub] = NewPath(level - BITS, tail_);
+        }
+    }
+
+    void PopBackInPlace() {
+        assert(size_ > 0);
+        if(size_ == 1) {
+            PersistentVector().Swap(*this);
+            return;
+        }
+        if(size_ - TailOffset() > 1) {
+            Leaf* tail = EditableLeaf(tail_);
+            tail->Elements()[--tail->count].~T();
+            --size_;
+            return;
+        }
+        // Последний элемент хвоста удаляется, хвостом становится последний лист дерева
+        Node* new_tail = root_;
+        for(unsigned level = shift_; level > 0; level -= BITS) {
+            new_tail = AsBranch(new_tail)->children[((size_ - 2) >> level) & MASK];
+        }
+        Retain(new_tail);
+        try {
+            if(PopTail(shift_, root_)) {
+                Release(std::exchange(root_, nullptr), shift_);
+                shift_ = BITS;
+            }
+        } catch (...) {
+            Release(new_tail, 0);
+            throw;
+        }
+        if(shift_ > BITS && AsBranch(root_)->children[1] == nullptr) {
+            // У корня остался один потомок, дерево теряет уровень
+            Node* child = Retain(AsBranch(root_)->children[0]);
+            Release(std::exchange(root_, child), shift_);
+            shift_ -= BITS;
+        }
+        Release(std::exchange(tail_, new_tail), 0);
+        --size_;
+    }
+
+    // Удаляет последний лист из поддерева slot уровня level. Возвращает true, если
+    // поддерево опустело
+    bool PopTail(unsigned level, Node*& slot) {
+        const size_t sub = ((size_ - 2) >> level) & MASK;
+        Branch* branch = EditableBranch(slot, level);
+        if(level == BITS || PopTail(level - BITS, branch->children[sub])) {
+            Release(std::exchange(branch->children[sub], nullptr), level - BITS);
+        }
+        return sub == 0 && branch->children[0] == nullptr;
+    }
+
+    Node* root_ = nullptr;
+    Node* tail_ = nullptr;
+    size_t size_ = 0;
+    unsigned shift_ = BITS;
+};
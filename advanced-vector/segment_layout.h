@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+
+// Номер старшего единичного бита value, value должно быть больше нуля
+constexpr size_t FloorLog2(size_t value) noexcept {
+#if defined(__GNUC__)
+    return sizeof(unsigned long long) * 8 - 1 - static_cast<size_t>(__builtin_clzll(value));
+#else
+    size_t result = 0;
+    while(value >>= 1) {
+        ++result;
+    }
+    return result;
+#endif
+}
+
+// Разбиение номеров элементов на сегменты, размеры которых растут вдвое: сегмент k
+// вмещает First << k элементов и начинается с номера First * (2^k - 1). Номер сегмента
+// по номеру элемента вычисляется одной инструкцией поиска старшего бита
+template <size_t First>
+struct GeometricSegmentLayout {
+    static_assert(First > 0 && (First & (First - 1)) == 0, "First segment size must be a power of two");
+
+    static constexpr size_t FIRST_SEGMENT_SIZE = First;
+    static constexpr size_t MAX_SEGMENTS = sizeof(size_t) * 8 - FloorLog2(First);
+
+    struct Location {
+        size_t segment;
+        size_t offset;
+    };
+
+    static constexpr size_t SegmentSize(size_t k) noexcept {
+        return First << k;
+    }
+
+    // Номер первого элемента сегмента k
+    static constexpr size_t SegmentStart(size_t k) noexcept {
+        return First * ((size_t{1} << k) - 1);
+    }
+
+    // Наибольшее количество элементов, номера которых помещаются в MAX_SEGMENTS сегментов
+    static constexpr size_t MaxSize() noexcept {
+        return SegmentStart(MAX_SEGMENTS - 1) + (SegmentSize(MAX_SEGMENTS - 1) - 1);
+    }
+
+    static constexpr Location Locate(size_t index) noexcept {
+        const size_t k = FloorLog2(index / First + 1);
+        return {k, index - SegmentStart(k)};
+    }
+};
@@ -0,0 +1,365 @@
+#pragma once
+#include "vector.h"
+#include "segment_layout.h"
+#include "span.h"
+
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Вектор, растущий добавлением сегментов RawMemory, размеры которых увеличиваются вдвое:
+// сегмент k вмещает FIRST_SEGMENT_SIZE << k элементов. При росте элементы не переезжают,
+// поэтому указатели и ссылки на них остаются действительными, пока элемент не удалён.
+// Доступ по номеру выполняется за O(1): номер сегмента равен номеру старшего бита.
+// Внутри сегмента элементы лежат непрерывно, и GetSegment позволяет обрабатывать их
+// векторизуемыми циклами
+template <typename T, typename Alloc = std::allocator<T>>
+class SegmentedVector {
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using Layout = GeometricSegmentLayout<16>;
+
+    template <bool IsConst>
+    class Iterator;
+
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    static constexpr size_t FIRST_SEGMENT_SIZE = Layout::FIRST_SEGMENT_SIZE;
+
+    SegmentedVector() = default;
+
+    explicit SegmentedVector(const Alloc& alloc) noexcept : alloc_(alloc) {
+    }
+
+    explicit SegmentedVector(size_t size, const Alloc& alloc = Alloc()) : SegmentedVector(alloc) {
+        Resize(size);
+    }
+
+    SegmentedVector(const SegmentedVector& other)
+        : SegmentedVector(other, AllocTraits::select_on_container_copy_construction(other.alloc_)) {
+    }
+
+    SegmentedVector(SegmentedVector&& other) noexcept
+        : alloc_(other.alloc_)
+        , segments_(std::move(other.segments_))
+        , size_(std::exchange(other.size_, 0)) {
+    }
+
+    SegmentedVector& operator=(const SegmentedVector& rhs) {
+        if(this != &rhs) {
+            constexpr bool propagate = AllocTraits::propagate_on_container_copy_assignment::value;
+            SegmentedVector rhs_copy(rhs, propagate ? rhs.alloc_ : alloc_);
+            SwapStorage(rhs_copy);
+        }
+        return *this;
+    }
+
+    SegmentedVector& operator=(SegmentedVector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                                               || AllocTraits::is_always_equal::value) {
+        if(this != &rhs) {
+            if constexpr (!AllocTraits::propagate_on_container_move_assignment::value
+                          && !AllocTraits::is_always_equal::value) {
+                if(alloc_ != rhs.alloc_) {
+                    // Чужие сегменты заимствовать нельзя, перемещаем элементы в память своего аллокатора
+                    SegmentedVector moved(alloc_);
+                    moved.Reserve(rhs.size_);
+                    for(T& value : rhs) {
+                        moved.EmplaceBack(std::move(value));
+                    }
+                    SwapStorage(moved);
+                    rhs.Clear();
+                    return *this;
+                }
+            }
+            SegmentedVector old(std::move(*this));
+            SwapStorage(rhs);
+        }
+        return *this;
+    }
+
+    ~SegmentedVector() {
+        DestroyFrom(0);
+    }
+
+    // Если propagate_on_container_swap ложно, аллокаторы векторов должны быть равны
+    void Swap(SegmentedVector& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            SwapStorage(other);
+        } else {
+            assert(alloc_ == other.alloc_);
+            segments_.Swap(other.segments_);
+            std::swap(size_, other.size_);
+        }
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    // Добавляет сегменты, пока ёмкость не станет не меньше new_capacity.
+    // Существующие элементы не переносятся
+    void Reserve(size_t new_capacity) {
+        if(new_capacity > Layout::MaxSize()) {
+            throw std::length_error("SegmentedVector is too large");
+        }
+        while(Capacity() < new_capacity) {
+            AddSegment();
+        }
+    }
+
+    void Resize(size_t new_size) {
+        if(new_size < size_) {
+            DestroyFrom(new_size);
+        }
+        Reserve(new_size);
+        while(size_ < new_size) {
+            EmplaceBack();
+        }
+    }
+
+    // Разрушает элементы, сохраняя сегменты для повторного использования
+    void Clear() noexcept {
+        DestroyFrom(0);
+    }
+
+    // Разрушает элементы и освобождает все сегменты
+    void ClearAndRelease() noexcept {
+        DestroyFrom(0);
+        segments_.Clear();
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if(size_ == Capacity()) {
+            Reserve(size_ + 1);
+        }
+        const typename Layout::Location location = Layout::Locate(size_);
+        T* elem = new (segments_[location.segment] + location.offset) T(std::forward<Args>(args)...);
+        ++size_;
+        return *elem;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        DestroyFrom(size_ - 1);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return Layout::SegmentStart(segments_.Size());
+    }
+
+    // Количество сегментов, в которых есть хотя бы один элемент
+    size_t SegmentCount() const noexcept {
+        return size_ == 0 ? 0 : Layout::Locate(size_ - 1).segment + 1;
+    }
+
+    // Элементы сегмента k, k < SegmentCount()
+    Span<T> GetSegment(size_t k) noexcept {
+        assert(k < SegmentCount());
+        const size_t first = Layout::SegmentStart(k);
+        return Span<T>(segments_[k].GetAddress(), std::min(Layout::SegmentSize(k), size_ - first));
+    }
+
+    Span<const T> GetSegment(size_t k) const noexcept {
+        return const_cast<SegmentedVector&>(*this).GetSegment(k);
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SegmentedVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        const typename Layout::Location location = Layout::Locate(index);
+        return segments_[location.segment][location.offset];
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+private:
+    // Итератор хранит номер элемента, поэтому остаётся действительным при добавлении сегментов
+    template <bool IsConst>
+    class Iterator {
+        using Container = std::conditional_t<IsConst, const SegmentedVector, SegmentedVector>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        Iterator() = default;
+
+        Iterator(Container* container, size_t index) noexcept : container_(container), index_(index) {
+        }
+
+        // Позволяет передавать iterator туда, где ожидается const_iterator
+        template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other) noexcept : container_(other.container_), index_(other.index_) {
+        }
+
+        reference operator*() const noexcept {
+            return (*container_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return &**this;
+        }
+
+        reference operator[](difference_type offset) const noexcept {
+            return *(*this + offset);
+        }
+
+        Iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) noexcept {
+            Iterator result = *this;
+            ++index_;
+            return result;
+        }
+
+        Iterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        Iterator operator--(int) noexcept {
+            Iterator result = *this;
+            --index_;
+            return result;
+        }
+
+        Iterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend Iterator operator+(difference_type offset, Iterator it) noexcept {
+            return it += offset;
+        }
+
+        friend Iterator operator-(Iterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return static_cast<difference_type>(lhs.index_) - static_cast<difference_type>(rhs.index_);
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+        friend bool operator<(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+
+        friend bool operator>(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ > rhs.index_;
+        }
+
+        friend bool operator<=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ <= rhs.index_;
+        }
+
+        friend bool operator>=(const Iterator& lhs, const Iterator& rhs) noexcept {
+            return lhs.index_ >= rhs.index_;
+        }
+
+    private:
+        friend class Iterator<!IsConst>;
+
+        Container* container_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    SegmentedVector(const SegmentedVector& other, const Alloc& alloc) : SegmentedVector(alloc) {
+        Reserve(other.size_);
+        for(const T& value : other) {
+            EmplaceBack(value);
+        }
+    }
+
+    void AddSegment() {
+        segments_.Reserve(Layout::MAX_SEGMENTS);
+        segments_.EmplaceBack(Layout::SegmentSize(segments_.Size()), alloc_);
+    }
+
+    // Разрушает элементы с номерами от new_size до конца, посегментно с последнего
+    void DestroyFrom(size_t new_size) noexcept {
+        while(size_ > new_size) {
+            const typename Layout::Location last = Layout::Locate(size_ - 1);
+            const size_t count = std::min(last.offset + 1, size_ - new_size);
+            DestroyN(segments_[last.segment] + (last.offset + 1 - count), count);
+            size_ -= count;
+        }
+    }
+
+    void SwapStorage(SegmentedVector& other) noexcept {
+        std::swap(alloc_, other.alloc_);
+        segments_.Swap(other.segments_);
+        std::swap(size_, other.size_);
+    }
+
+    Alloc alloc_;
+    Vector<RawMemory<T, Alloc>> segments_;
+    size_t size_ = 0;
+};
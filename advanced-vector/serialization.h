@@ -0,0 +1,296 @@
+#pragma once
+#include "vector.h"
+#include "span.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Двоичный формат Vector: заголовок SerializationHeader, за которым со смещения
+// data_offset следуют элементы. Элементы тривиально копируемых типов записываются одним
+// непрерывным блоком в порядке байтов записавшей машины, остальные — поэлементно через
+// ElementSerializer<T>.
+// Writer должен предоставлять Write(const void* data, size_t size), Reader —
+// Read(void* data, size_t size), возвращающую количество прочитанных байт. Ошибки формата
+// и преждевременный конец данных сообщаются исключением SerializationError
+
+class SerializationError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct SerializationHeader {
+    static constexpr char MAGIC[4] = {'A', 'V', 'E', 'C'};
+    static constexpr uint16_t CURRENT_VERSION = 1;
+    // Записывается в порядке байтов машины и позволяет обнаружить чужой порядок
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    // Элементы записаны одним блоком
+    static constexpr uint16_t BULK = 1;
+
+    char magic[4] = {MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3]};
+    uint16_t version = CURRENT_VERSION;
+    uint16_t flags = 0;
+    uint32_t byte_order = BYTE_ORDER_MARK;
+    // Размер и выравнивание элемента для блочной записи, для поэлементной — нули
+    uint32_t element_size = 0;
+    uint32_t element_alignment = 0;
+    // Смещение первого элемента от начала заголовка
+    uint32_t data_offset = sizeof(SerializationHeader);
+    uint64_t count = 0;
+};
+
+static_assert(sizeof(SerializationHeader) == 32, "Serialization header layout must not depend on the compiler");
+
+// Поэлементная запись нетривиальных типов. Для собственных типов определяется
+// специализацией с функциями Write(writer, value) и Read(reader)
+template <typename T, typename = void>
+struct ElementSerializer;
+
+template <typename Writer, typename T>
+void WriteValue(Writer& writer, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    writer.Write(&value, sizeof(T));
+}
+
+template <typename Reader>
+void ReadBytes(Reader& reader, void* data, size_t size) {
+    if(static_cast<size_t>(reader.Read(data, size)) != size) {
+        throw SerializationError("Unexpected end of serialized data");
+    }
+}
+
+template <typename T, typename Reader>
+T ReadValue(Reader& reader) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    ReadBytes(reader, &value, sizeof(T));
+    return value;
+}
+
+template <typename T, typename Alloc, typename Growth, typename Stats, typename Checks, typename Writer>
+void Serialize(const Vector<T, Alloc, Growth, Stats, Checks>& vector, Writer& writer) {
+    SerializationHeader header;
+    header.count = vector.Size();
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        header.flags = SerializationHeader::BULK;
+        header.element_size = sizeof(T);
+        header.element_alignment = alignof(T);
+        // Элементы начинаются на границе своего выравнивания, если на ней начинается буфер,
+        // чтобы DeserializeView мог читать их на месте
+        header.data_offset = static_cast<uint32_t>(std::max(sizeof(SerializationHeader), alignof(T)));
+    }
+    WriteValue(writer, header);
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        static const unsigned char padding[alignof(T)] = {};
+        if(header.data_offset > sizeof(SerializationHeader)) {
+            writer.Write(padding, header.data_offset - sizeof(SerializationHeader));
+        }
+        if(vector.Size() != 0) {
+            writer.Write(vector.Data(), vector.Size() * sizeof(T));
+        }
+    } else {
+        for(const T& value : vector) {
+            ElementSerializer<T>::Write(writer, value);
+        }
+    }
+}
+
+namespace serialization_detail {
+
+// Данные не читаются большими порциями, чем эта, так что повреждённый счётчик элементов
+// приводит к ошибке конца данных, а не к попытке выделить гигантский буфер
+inline constexpr size_t MAX_CHUNK_BYTES = size_t{1} << 20;
+
+template <typename T>
+void CheckHeader(const SerializationHeader& header) {
+    if(std::memcmp(header.magic, SerializationHeader::MAGIC, sizeof(header.magic)) != 0) {
+        throw SerializationError("Not a serialized Vector");
+    }
+    if(header.version > SerializationHeader::CURRENT_VERSION) {
+        throw SerializationError("Unsupported serialization version " + std::to_string(header.version));
+    }
+    if(header.byte_order != SerializationHeader::BYTE_ORDER_MARK) {
+        throw SerializationError("Serialized Vector has a different byte order");
+    }
+    if(header.data_offset < sizeof(SerializationHeader)) {
+        throw SerializationError("Corrupted serialization header");
+    }
+    const bool bulk = (header.flags & SerializationHeader::BULK) != 0;
+    if(bulk != std::is_trivially_copyable_v<T>) {
+        throw SerializationError("Serialized Vector has a different element kind");
+    }
+    if(bulk && (header.element_size != sizeof(T) || header.element_alignment != alignof(T))) {
+        throw SerializationError("Serialized Vector has a different element layout");
+    }
+}
+
+}  // namespace serialization_detail
+
+// Заменяет содержимое vector прочитанными элементами. При ошибке vector не меняется
+template <typename T, typename Alloc, typename Growth, typename Stats, typename Checks, typename Reader>
+void Deserialize(Reader& reader, Vector<T, Alloc, Growth, Stats, Checks>& vector) {
+    const auto header = ReadValue<SerializationHeader>(reader);
+    serialization_detail::CheckHeader<T>(header);
+    for(size_t skipped = sizeof(SerializationHeader); skipped < header.data_offset; ++skipped) {
+        ReadValue<char>(reader);
+    }
+
+    Vector<T, Alloc, Growth, Stats, Checks> result(vector.GetAllocator());
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        const size_t chunk = std::max<size_t>(serialization_detail::MAX_CHUNK_BYTES / sizeof(T), 1);
+        while(result.Size() < header.count) {
+            const size_t old_size = result.Size();
+            const size_t new_size = old_size + std::min<uint64_t>(chunk, header.count - old_size);
+            if(new_size > result.Capacity()) {
+                result.Reserve(std::min<uint64_t>(header.count, std::max(new_size, result.Capacity() * 2)));
+            }
+            result.ResizeAndOverwrite(new_size, [&reader, old_size](T* data, size_t size) {
+                ReadBytes(reader, data + old_size, (size - old_size) * sizeof(T));
+                return size;
+            });
+        }
+    } else {
+        for(uint64_t i = 0; i < header.count; ++i) {
+            result.PushBack(ElementSerializer<T>::Read(reader));
+        }
+    }
+    vector.Swap(result);
+}
+
+template <typename VectorType, typename Reader>
+VectorType Deserialize(Reader& reader) {
+    VectorType result;
+    Deserialize(reader, result);
+    return result;
+}
+
+// Возвращает элементы сериализованного вектора прямо в буфере bytes, не копируя их.
+// Буфер должен пережить результат, а его данные должны быть выровнены по alignof(T)
+template <typename T>
+Span<const T> DeserializeView(Span<const unsigned char> bytes) {
+    static_assert(std::is_trivially_copyable_v<T>, "Zero-copy view requires trivially copyable T");
+    if(bytes.Size() < sizeof(SerializationHeader)) {
+        throw SerializationError("Unexpected end of serialized data");
+    }
+    SerializationHeader header;
+    std::memcpy(&header, bytes.Data(), sizeof(header));
+    serialization_detail::CheckHeader<T>(header);
+    if(header.data_offset > bytes.Size() || header.count > (bytes.Size() - header.data_offset) / sizeof(T)) {
+        throw SerializationError("Unexpected end of serialized data");
+    }
+    const unsigned char* data = bytes.Data() + header.data_offset;
+    if(reinterpret_cast<uintptr_t>(data) % alignof(T) != 0) {
+        throw SerializationError("Serialized data is misaligned for zero-copy access");
+    }
+    return Span<const T>(reinterpret_cast<const T*>(data), static_cast<size_t>(header.count));
+}
+
+template <typename Char, typename Traits, typename StringAlloc>
+struct ElementSerializer<std::basic_string<Char, Traits, StringAlloc>> {
+    using String = std::basic_string<Char, Traits, StringAlloc>;
+
+    template <typename Writer>
+    static void Write(Writer& writer, const String& value) {
+        WriteValue(writer, static_cast<uint64_t>(value.size()));
+        writer.Write(value.data(), value.size() * sizeof(Char));
+    }
+
+    template <typename Reader>
+    static String Read(Reader& reader) {
+        const auto size = ReadValue<uint64_t>(reader);
+        String value;
+        for(uint64_t read = 0; read < size;) {
+            const size_t chunk = std::min<uint64_t>(size - read, serialization_detail::MAX_CHUNK_BYTES / sizeof(Char));
+            value.resize(value.size() + chunk);
+            ReadBytes(reader, value.data() + read, chunk * sizeof(Char));
+            read += chunk;
+        }
+        return value;
+    }
+};
+
+// Вложенные векторы записываются целиком, со своим заголовком
+template <typename T, typename Alloc, typename Growth, typename Stats, typename Checks>
+struct ElementSerializer<Vector<T, Alloc, Growth, Stats, Checks>> {
+    template <typename Writer>
+    static void Write(Writer& writer, const Vector<T, Alloc, Growth, Stats, Checks>& value) {
+        Serialize(value, writer);
+    }
+
+    template <typename Reader>
+    static Vector<T, Alloc, Growth, Stats, Checks> Read(Reader& reader) {
+        return Deserialize<Vector<T, Alloc, Growth, Stats, Checks>>(reader);
+    }
+};
+
+// Запись в поток std::ostream
+class StreamWriter {
+public:
+    explicit StreamWriter(std::ostream& out) noexcept : out_(out) {
+    }
+
+    void Write(const void* data, size_t size) {
+        out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if(!out_) {
+            throw SerializationError("Failed to write serialized data");
+        }
+    }
+
+private:
+    std::ostream& out_;
+};
+
+// Чтение из потока std::istream
+class StreamReader {
+public:
+    explicit StreamReader(std::istream& in) noexcept : in_(in) {
+    }
+
+    size_t Read(void* data, size_t size) {
+        in_.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+        return static_cast<size_t>(in_.gcount());
+    }
+
+private:
+    std::istream& in_;
+};
+
+// Запись в конец байтового Vector
+class MemoryWriter {
+public:
+    explicit MemoryWriter(Vector<unsigned char>& buffer) noexcept : buffer_(buffer) {
+    }
+
+    void Write(const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        buffer_.Insert(buffer_.cend(), bytes, bytes + size);
+    }
+
+private:
+    Vector<unsigned char>& buffer_;
+};
+
+// Последовательное чтение из непрерывного буфера
+class MemoryReader {
+public:
+    explicit MemoryReader(Span<const unsigned char> data) noexcept : data_(data) {
+    }
+
+    size_t Read(void* data, size_t size) noexcept {
+        const size_t available = std::min(size, data_.Size() - offset_);
+        if(available != 0) {
+            std::memcpy(data, data_.Data() + offset_, available);
+        }
+        offset_ += available;
+        return available;
+    }
+
+private:
+    Span<const unsigned char> data_;
+    size_t offset_ = 0;
+};
@@ -0,0 +1,277 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Вектор, хранящий до N элементов внутри самого объекта. При переполнении элементы
+// переезжают в динамический буфер RawMemory и остаются в нём до разрушения вектора.
+// Интерфейс и гарантии безопасности исключений совпадают с Vector
+template <typename T, size_t N, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth>
+class SmallVector {
+    static_assert(N > 0, "Inline capacity must be positive");
+
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+
+    SmallVector() = default;
+
+    explicit SmallVector(const Alloc& alloc) noexcept : heap_(alloc) {
+    }
+
+    explicit SmallVector(size_t size, const Alloc& alloc = Alloc()) : heap_(alloc) {
+        Reserve(size);
+        std::uninitialized_value_construct_n(begin(), size);
+        size_ = size;
+    }
+
+    SmallVector(const SmallVector& other)
+        : heap_(AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
+        Reserve(other.size_);
+        std::uninitialized_copy_n(other.begin(), other.size_, begin());
+        size_ = other.size_;
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : heap_(other.GetAllocator()) {
+        if(other.IsInline()) {
+            std::uninitialized_move_n(other.begin(), other.size_, begin());
+            size_ = other.size_;
+            other.Clear();
+        } else {
+            heap_.Swap(other.heap_);
+            std::swap(size_, other.size_);
+        }
+    }
+
+    SmallVector& operator=(const SmallVector& rhs) {
+        if(this != &rhs) {
+            if(rhs.size_ > Capacity()) {
+                SmallVector rhs_copy(rhs);
+                *this = std::move(rhs_copy);
+            } else {
+                if(rhs.size_ < size_) {
+                    std::copy(rhs.begin(), rhs.end(), begin());
+                    DestroyN(begin() + rhs.size_, size_ - rhs.size_);
+                } else {
+                    std::copy(rhs.begin(), rhs.begin() + size_, begin());
+                    std::uninitialized_copy_n(rhs.begin() + size_, rhs.size_ - size_, end());
+                }
+                size_ = rhs.size_;
+            }
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                                       && AllocTraits::is_always_equal::value) {
+        if(this != &rhs) {
+            Clear();
+            if(!rhs.IsInline() && CanStealHeap(rhs)) {
+                // Свой динамический буфер (если он был) достаётся rhs
+                heap_ = std::move(rhs.heap_);
+                std::swap(size_, rhs.size_);
+            } else {
+                Reserve(rhs.size_);
+                std::uninitialized_move_n(rhs.begin(), rhs.size_, begin());
+                size_ = rhs.size_;
+                rhs.Clear();
+            }
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        DestroyN(begin(), size_);
+    }
+
+    void Swap(SmallVector& other) noexcept(std::is_nothrow_move_constructible_v<T>
+                                           && AllocTraits::is_always_equal::value) {
+        SmallVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return heap_.GetAllocator();
+    }
+
+    void Reserve(size_t new_capacity) {
+        if(new_capacity <= Capacity()) {
+            return;
+        }
+        RawMemory<T, Alloc> new_heap(new_capacity, heap_.GetAllocator());
+        UninitializedTransferN(begin(), size_, new_heap.GetAddress());
+        DestroyAndSwap(new_heap);
+    }
+
+    void Resize(size_t new_size) {
+        if(new_size < size_) {
+            DestroyN(begin() + new_size, size_ - new_size);
+            size_ = new_size;
+        }
+        if(new_size > size_) {
+            Reserve(new_size);
+            std::uninitialized_value_construct_n(end(), new_size - size_);
+            size_ = new_size;
+        }
+    }
+
+    void Clear() noexcept {
+        DestroyN(begin(), size_);
+        size_ = 0;
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator pos, Args&&... args) {
+        if(size_ == Capacity()) {
+            return ReallocationEmplace(pos, std::forward<Args>(args)...);
+        }
+        return NoReallocationEmplace(pos, std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return *Emplace(end(), std::forward<Args>(args)...);
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        DestroyN(end() - 1, 1);
+        --size_;
+    }
+
+    iterator Erase(const_iterator pos) noexcept {
+        iterator no_const_pos = const_cast<iterator>(pos);
+        MoveOrCopyAssign(no_const_pos + 1, end(), no_const_pos);
+        PopBack();
+        return no_const_pos;
+    }
+
+    iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return IsInline() ? N : heap_.Capacity();
+    }
+
+    // Возвращает true, пока элементы хранятся внутри объекта
+    bool IsInline() const noexcept {
+        return heap_.GetAddress() == nullptr;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SmallVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < size_);
+        return begin()[index];
+    }
+
+    iterator begin() noexcept {
+        return IsInline() ? InlineData() : heap_.GetAddress();
+    }
+
+    iterator end() noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return const_cast<SmallVector&>(*this).begin();
+    }
+
+    const_iterator end() const noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+private:
+    T* InlineData() noexcept {
+        return reinterpret_cast<T*>(inline_buffer_);
+    }
+
+    bool CanStealHeap(const SmallVector& other) const noexcept {
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value
+                      || AllocTraits::is_always_equal::value) {
+            return true;
+        } else {
+            return heap_.GetAllocator() == other.heap_.GetAllocator();
+        }
+    }
+
+    size_t NextCapacity() const noexcept {
+        return Growth::NextCapacity(Capacity(), size_ + 1, sizeof(T));
+    }
+
+    void DestroyAndSwap(RawMemory<T, Alloc>& new_heap) {
+        DestroyTransferredN(begin(), size_);
+        heap_.Swap(new_heap);
+    }
+
+    template <typename... Args>
+    iterator ReallocationEmplace(const_iterator pos, Args&&... args) {
+        size_t new_pos = pos - begin();
+        RawMemory<T, Alloc> new_heap(NextCapacity(), heap_.GetAllocator());
+        T* elem = new (new_heap + new_pos) T(std::forward<Args>(args)...);
+        try {
+            UninitializedTransferN(begin(), new_pos, new_heap.GetAddress());
+        } catch (...) {
+            elem->~T();
+            throw;
+        }
+        try {
+            UninitializedTransferN(begin() + new_pos, size_ - new_pos, new_heap + new_pos + 1);
+        } catch (...) {
+            DestroyN(new_heap.GetAddress(), new_pos + 1);
+            throw;
+        }
+        DestroyAndSwap(new_heap);
+        ++size_;
+        return elem;
+    }
+
+    template <typename... Args>
+    iterator NoReallocationEmplace(const_iterator pos, Args&&... args) {
+        const size_t new_pos = pos - begin();
+        T* elem = new_pos == size_ ? new (end()) T(std::forward<Args>(args)...)
+                                   : ShiftAndEmplace(begin(), size_, new_pos, std::forward<Args>(args)...);
+        ++size_;
+        return elem;
+    }
+
+    alignas(T) unsigned char inline_buffer_[N * sizeof(T)];
+    RawMemory<T, Alloc> heap_;
+    size_t size_ = 0;
+};
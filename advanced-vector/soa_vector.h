@@ -0,0 +1,241 @@
+#pragma once
+#include "vector.h"
+#include "span.h"
+
+#include <cassert>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Вектор записей, хранящий каждое поле в отдельном столбце RawMemory. Столбцы имеют
+// общие размер и ёмкость и растут одновременно. Цикл, читающий одно-два поля, проходит
+// их столбцы последовательно, не загружая в кеш остальные поля, и легко векторизуется.
+// operator[] возвращает кортеж ссылок на поля строки: его можно разобрать структурной
+// привязкой и присвоить ему кортеж значений
+template <typename... Fields>
+class SoaVector {
+    static_assert(sizeof...(Fields) > 0, "SoaVector needs at least one field");
+
+    using Columns = std::tuple<RawMemory<Fields>...>;
+    static constexpr size_t NUM_COLUMNS = sizeof...(Fields);
+
+public:
+    template <size_t I>
+    using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    using value_type = std::tuple<Fields...>;
+    using reference = std::tuple<Fields&...>;
+    using const_reference = std::tuple<const Fields&...>;
+
+    SoaVector() = default;
+
+    explicit SoaVector(size_t size) {
+        Resize(size);
+    }
+
+    SoaVector(const SoaVector& other) {
+        Reserve(other.size_);
+        ConstructColumns(columns_, 0, other.size_, [&other](auto column, auto* dst, size_t count) {
+            std::uninitialized_copy_n(std::get<decltype(column)::value>(other.columns_).GetAddress(), count, dst);
+        });
+        size_ = other.size_;
+    }
+
+    SoaVector(SoaVector&& other) noexcept
+        : columns_(std::move(other.columns_))
+        , size_(std::exchange(other.size_, 0)) {
+    }
+
+    SoaVector& operator=(const SoaVector& rhs) {
+        if(this != &rhs) {
+            SoaVector rhs_copy(rhs);
+            Swap(rhs_copy);
+        }
+        return *this;
+    }
+
+    SoaVector& operator=(SoaVector&& rhs) noexcept {
+        if(this != &rhs) {
+            SoaVector old(std::move(*this));
+            Swap(rhs);
+        }
+        return *this;
+    }
+
+    ~SoaVector() {
+        DestroyRows(0, size_);
+    }
+
+    void Swap(SoaVector& other) noexcept {
+        SwapColumns(other.columns_, std::index_sequence_for<Fields...>{});
+        std::swap(size_, other.size_);
+    }
+
+    // Переносит все столбцы в буферы ёмкостью new_capacity. Если перенос какого-либо
+    // столбца выбросил исключение, вектор остаётся прежним
+    void Reserve(size_t new_capacity) {
+        if(new_capacity <= Capacity()) {
+            return;
+        }
+        Columns new_columns{RawMemory<Fields>(new_capacity)...};
+        // Сначала столбцы, перенос которых может выбросить исключение: если это случится,
+        // исходные элементы ещё не тронуты, и достаточно разрушить готовые копии
+        TransferColumns<0, true>(new_columns);
+        TransferColumns<0, false>(new_columns);
+        std::apply([this](auto&... columns) {
+            (DestroyTransferredN(columns.GetAddress(), size_), ...);
+        }, columns_);
+        SwapColumns(new_columns, std::index_sequence_for<Fields...>{});
+    }
+
+    void Resize(size_t new_size) {
+        if(new_size < size_) {
+            DestroyRows(new_size, size_);
+            size_ = new_size;
+        }
+        if(new_size > size_) {
+            Reserve(new_size);
+            ConstructColumns(columns_, size_, new_size - size_, [](auto /*column*/, auto* dst, size_t count) {
+                std::uninitialized_value_construct_n(dst, count);
+            });
+            size_ = new_size;
+        }
+    }
+
+    void Clear() noexcept {
+        DestroyRows(0, size_);
+        size_ = 0;
+    }
+
+    // Добавляет строку, создавая каждое поле из соответствующего аргумента. Если создание
+    // поля выбросило исключение, уже созданные поля строки разрушаются
+    template <typename... Args>
+    reference EmplaceBack(Args&&... args) {
+        static_assert(sizeof...(Args) == NUM_COLUMNS, "EmplaceBack takes one argument per field");
+        if(size_ == Capacity()) {
+            // Аргументы могут ссылаться на поля вектора, которые переедут при росте
+            value_type row(std::forward<Args>(args)...);
+            Reserve(NextCapacity());
+            ConstructRowFrom(std::move(row), std::index_sequence_for<Fields...>{});
+        } else {
+            ConstructRow(std::forward<Args>(args)...);
+        }
+        ++size_;
+        return (*this)[size_ - 1];
+    }
+
+    void PopBack() noexcept {
+        assert(size_ > 0);
+        DestroyRows(size_ - 1, size_);
+        --size_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return std::get<0>(columns_).Capacity();
+    }
+
+    // Непрерывный столбец поля I
+    template <size_t I>
+    Span<Field<I>> Column() noexcept {
+        return Span<Field<I>>(std::get<I>(columns_).GetAddress(), size_);
+    }
+
+    template <size_t I>
+    Span<const Field<I>> Column() const noexcept {
+        return Span<const Field<I>>(std::get<I>(columns_).GetAddress(), size_);
+    }
+
+    reference operator[](size_t index) noexcept {
+        assert(index < size_);
+        return std::apply([index](auto&... columns) {
+            return reference(columns[index]...);
+        }, columns_);
+    }
+
+    const_reference operator[](size_t index) const noexcept {
+        assert(index < size_);
+        return std::apply([index](const auto&... columns) {
+            return const_reference(columns[index]...);
+        }, columns_);
+    }
+
+private:
+    // Вызывает construct(column, dst, count) для столбцов начиная с I, где column —
+    // std::integral_constant с номером столбца. Если столбец не создан, созданные до него
+    // столбцы разрушаются
+    template <size_t I = 0, typename Construct>
+    static void ConstructColumns(Columns& columns, size_t offset, size_t count, const Construct& construct) {
+        if constexpr (I < NUM_COLUMNS) {
+            construct(std::integral_constant<size_t, I>{}, std::get<I>(columns) + offset, count);
+            try {
+                ConstructColumns<I + 1>(columns, offset, count, construct);
+            } catch (...) {
+                DestroyN(std::get<I>(columns) + offset, count);
+                throw;
+            }
+        }
+    }
+
+    // Создаёт поля строки с номером size_ из args
+    template <typename... Args>
+    void ConstructRow(Args&&... args) {
+        auto values = std::forward_as_tuple(std::forward<Args>(args)...);
+        ConstructColumns(columns_, size_, 1, [&values](auto column, auto* dst, size_t /*count*/) {
+            constexpr size_t I = decltype(column)::value;
+            new (dst) Field<I>(std::get<I>(std::move(values)));
+        });
+    }
+
+    template <size_t... I>
+    void ConstructRowFrom(value_type&& row, std::index_sequence<I...>) {
+        ConstructRow(std::get<I>(std::move(row))...);
+    }
+
+    template <typename T>
+    static constexpr bool TransferMayThrow() noexcept {
+        return !is_trivially_relocatable_v<T> && !std::is_nothrow_move_constructible_v<T>;
+    }
+
+    // Переносит в new_columns столбцы начиная с I, для которых TransferMayThrow равно MayThrow
+    template <size_t I, bool MayThrow>
+    void TransferColumns(Columns& new_columns) {
+        if constexpr (I < NUM_COLUMNS) {
+            if constexpr (TransferMayThrow<Field<I>>() == MayThrow) {
+                UninitializedTransferN(std::get<I>(columns_).GetAddress(), size_, std::get<I>(new_columns).GetAddress());
+                try {
+                    TransferColumns<I + 1, MayThrow>(new_columns);
+                } catch (...) {
+                    DestroyN(std::get<I>(new_columns).GetAddress(), size_);
+                    throw;
+                }
+            } else {
+                TransferColumns<I + 1, MayThrow>(new_columns);
+            }
+        }
+    }
+
+    template <size_t... I>
+    void SwapColumns(Columns& other, std::index_sequence<I...>) noexcept {
+        (std::get<I>(columns_).Swap(std::get<I>(other)), ...);
+    }
+
+    void DestroyRows(size_t first, size_t last) noexcept {
+        std::apply([first, last](auto&... columns) {
+            (DestroyN(columns + first, last - first), ...);
+        }, columns_);
+    }
+
+    // Ёмкость растёт по DoublingGrowth, исходя из размера строки целиком
+    size_t NextCapacity() const noexcept {
+        return DoublingGrowth::NextCapacity(Capacity(), size_ + 1, (sizeof(Fields) + ...));
+    }
+
+    Columns columns_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,283 @@
+#pragma once
+#include "vector.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace static_vector_detail {
+
+// Наименьший беззнаковый тип, вмещающий N
+template <size_t N>
+using SizeType = std::conditional_t<N <= UINT8_MAX, uint8_t,
+                 std::conditional_t<N <= UINT16_MAX, uint16_t,
+                 std::conditional_t<N <= UINT32_MAX, uint32_t, size_t>>>;
+
+// Элементы таких типов можно хранить в массиве T и изменять присваиванием, что допустимо
+// в constexpr. Лишние элементы массива не требуется разрушать
+template <typename T>
+inline constexpr bool IS_CONSTEXPR_STORAGE = std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>
+                                             && std::is_copy_assignable_v<T> && std::is_move_assignable_v<T>;
+
+// Массив T. Элементы за пределами размера инициализируются значением: constexpr
+// конструктор обязан инициализировать все члены, а constexpr копирование — читать их
+template <typename T, size_t N, bool = IS_CONSTEXPR_STORAGE<T>>
+struct Storage {
+    constexpr T* Data() noexcept {
+        return elements;
+    }
+
+    constexpr const T* Data() const noexcept {
+        return elements;
+    }
+
+    T elements[N]{};
+    SizeType<N> size = 0;
+};
+
+// Неинициализированный буфер, элементы которого создаются и разрушаются по одному
+template <typename T, size_t N>
+struct Storage<T, N, false> {
+    Storage() noexcept {
+    }
+
+    Storage(const Storage& other) {
+        std::uninitialized_copy_n(other.Data(), other.size, Data());
+        size = other.size;
+    }
+
+    Storage(Storage&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        std::uninitialized_move_n(other.Data(), other.size, Data());
+        size = other.size;
+        other.Clear();
+    }
+
+    Storage& operator=(const Storage& rhs) {
+        if(this != &rhs) {
+            Assign(rhs.Data(), rhs.size);
+        }
+        return *this;
+    }
+
+    Storage& operator=(Storage&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                               && std::is_nothrow_move_assignable_v<T>) {
+        if(this != &rhs) {
+            Assign(std::make_move_iterator(rhs.Data()), rhs.size);
+            rhs.Clear();
+        }
+        return *this;
+    }
+
+    ~Storage() {
+        DestroyN(Data(), size);
+    }
+
+    T* Data() noexcept {
+        return std::launder(reinterpret_cast<T*>(buffer));
+    }
+
+    const T* Data() const noexcept {
+        return std::launder(reinterpret_cast<const T*>(buffer));
+    }
+
+    void Clear() noexcept {
+        DestroyN(Data(), size);
+        size = 0;
+    }
+
+    // Присваивает общие элементы и создаёт или разрушает остальные
+    template <typename It>
+    void Assign(It first, size_t count) {
+        if(count < size) {
+            std::copy_n(first, count, Data());
+            DestroyN(Data() + count, size - count);
+        } else {
+            std::copy_n(first, size, Data());
+            std::uninitialized_copy_n(first + size, count - size, Data() + size);
+        }
+        size = static_cast<SizeType<N>>(count);
+    }
+
+    alignas(T) unsigned char buffer[N * sizeof(T)];
+    SizeType<N> size = 0;
+};
+
+}  // namespace static_vector_detail
+
+// Вектор ёмкостью не более N элементов, хранящихся внутри самого объекта, без обращений
+// к куче. Размер хранится в наименьшем беззнаковом типе, вмещающем N, так что для малых N
+// заголовок занимает один-два байта. Превышение ёмкости сообщается исключением
+// std::length_error, вектор при этом не меняется.
+// Для тривиально копируемых и присваиваемых T с конструктором по умолчанию элементы хранятся
+// в массиве T, и все операции доступны в constexpr, что позволяет строить таблицы при компиляции.
+// Такой вектор тривиально копируется, если тривиально копируется T. Для остальных T
+// интерфейс и гарантии безопасности исключений совпадают с Vector
+template <typename T, size_t N>
+class StaticVector {
+    static_assert(N > 0, "StaticVector capacity must be positive");
+
+    static constexpr bool IS_CONSTEXPR = static_vector_detail::IS_CONSTEXPR_STORAGE<T>;
+
+public:
+    using value_type = T;
+    using size_type = static_vector_detail::SizeType<N>;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    constexpr StaticVector() = default;
+
+    constexpr explicit StaticVector(size_t size) {
+        Resize(size);
+    }
+
+    constexpr size_t Size() const noexcept {
+        return storage_.size;
+    }
+
+    static constexpr size_t Capacity() noexcept {
+        return N;
+    }
+
+    constexpr bool Empty() const noexcept {
+        return storage_.size == 0;
+    }
+
+    constexpr void Resize(size_t new_size) {
+        CheckCapacity(new_size);
+        if constexpr (IS_CONSTEXPR) {
+            for(size_t i = Size(); i < new_size; ++i) {
+                storage_.Data()[i] = T();
+            }
+        } else if(new_size < Size()) {
+            DestroyN(begin() + new_size, Size() - new_size);
+        } else {
+            std::uninitialized_value_construct_n(end(), new_size - Size());
+        }
+        storage_.size = static_cast<size_type>(new_size);
+    }
+
+    constexpr void Clear() noexcept {
+        if constexpr (!IS_CONSTEXPR) {
+            DestroyN(begin(), Size());
+        }
+        storage_.size = 0;
+    }
+
+    template <typename... Args>
+    constexpr iterator Emplace(const_iterator pos, Args&&... args) {
+        CheckCapacity(Size() + 1);
+        const size_t offset = pos - cbegin();
+        T* data = begin();
+        if constexpr (IS_CONSTEXPR) {
+            // Аргументы могут ссылаться на сдвигаемые элементы
+            T value(std::forward<Args>(args)...);
+            for(size_t i = Size(); i > offset; --i) {
+                data[i] = std::move(data[i - 1]);
+            }
+            data[offset] = std::move(value);
+        } else if(offset == Size()) {
+            new (data + offset) T(std::forward<Args>(args)...);
+        } else {
+            ShiftAndEmplace(data, Size(), offset, std::forward<Args>(args)...);
+        }
+        ++storage_.size;
+        return data + offset;
+    }
+
+    template <typename... Args>
+    constexpr T& EmplaceBack(Args&&... args) {
+        return *Emplace(cend(), std::forward<Args>(args)...);
+    }
+
+    constexpr void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    constexpr void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    constexpr void PopBack() noexcept {
+        assert(!Empty());
+        if constexpr (!IS_CONSTEXPR) {
+            DestroyN(end() - 1, 1);
+        }
+        --storage_.size;
+    }
+
+    constexpr iterator Insert(const_iterator pos, const T& value) {
+        return Emplace(pos, value);
+    }
+
+    constexpr iterator Insert(const_iterator pos, T&& value) {
+        return Emplace(pos, std::move(value));
+    }
+
+    constexpr iterator Erase(const_iterator pos) noexcept {
+        return Erase(pos, pos + 1);
+    }
+
+    // Удаляет элементы [first, last), сдвигая хвост один раз
+    constexpr iterator Erase(const_iterator first, const_iterator last) noexcept {
+        const size_t offset = first - cbegin();
+        const size_t count = last - first;
+        T* data = begin();
+        if constexpr (IS_CONSTEXPR) {
+            for(size_t i = offset; i + count < Size(); ++i) {
+                data[i] = std::move(data[i + count]);
+            }
+        } else if(count != 0) {
+            MoveOrCopyAssign(data + offset + count, end(), data + offset);
+            DestroyN(end() - count, count);
+        }
+        storage_.size = static_cast<size_type>(Size() - count);
+        return data + offset;
+    }
+
+    constexpr const T& operator[](size_t index) const noexcept {
+        assert(index < Size());
+        return storage_.Data()[index];
+    }
+
+    constexpr T& operator[](size_t index) noexcept {
+        assert(index < Size());
+        return storage_.Data()[index];
+    }
+
+    constexpr iterator begin() noexcept {
+        return storage_.Data();
+    }
+
+    constexpr iterator end() noexcept {
+        return begin() + Size();
+    }
+
+    constexpr const_iterator begin() const noexcept {
+        return storage_.Data();
+    }
+
+    constexpr const_iterator end() const noexcept {
+        return begin() + Size();
+    }
+
+    constexpr const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    constexpr const_iterator cend() const noexcept {
+        return end();
+    }
+
+private:
+    static constexpr void CheckCapacity(size_t size) {
+        if(size > N) {
+            throw std::length_error("StaticVector capacity exceeded");
+        }
+    }
+
+    static_vector_detail::Storage<T, N> storage_;
+};
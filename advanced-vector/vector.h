@@ -1,162 +1,1168 @@
 #pragma once
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <new>
 #include <utility>
 #include <memory>
 #include <algorithm>
 #include <type_traits>
 #include <iostream>
+#include <iterator>
+#include <exception>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <thread>
 
+// Тип тривиально перемещаем, если перенос объекта в другую область памяти побайтовым
+// копированием с отказом от вызова деструктора исходного объекта эквивалентен
+// перемещению с последующим разрушением. Пользовательские типы (например, дескрипторы
+// строк) могут заявить о такой возможности специализацией этого шаблона
 template <typename T>
-class RawMemory {
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+};
+
+template <typename T, typename Deleter>
+struct is_trivially_relocatable<std::unique_ptr<T, Deleter>> : is_trivially_relocatable<Deleter> {
+};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+// Разрушает n элементов, начиная с first. Для тривиально разрушаемых типов не генерирует кода
+template <typename T>
+void DestroyN(T* first, size_t n) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for(T* last = first + n; first != last; ++first) {
+            first->~T();
+        }
+    }
+}
+
+// Переносит n элементов из from в неинициализированную память to при переезде в новый буфер.
+// Тривиально перемещаемые элементы переносятся одним memcpy, остальные перемещаются,
+// если перемещение не выбрасывает исключений, или копируются
+template <typename T>
+void UninitializedTransferN(T* from, size_t n, T* to) {
+    if constexpr (is_trivially_relocatable_v<T>) {
+        if(n != 0) {
+            std::memcpy(static_cast<void*>(to), from, n * sizeof(T));
+        }
+    } else if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+        std::uninitialized_move_n(from, n, to);
+    } else {
+        std::uninitialized_copy_n(from, n, to);
+    }
+}
+
+// Разрушает n исходных элементов, перенесённых функцией UninitializedTransferN.
+// Побайтово перенесённые элементы уже живут в новом буфере, их деструкторы не вызываются
+template <typename T>
+void DestroyTransferredN(T* from, size_t n) noexcept {
+    if constexpr (!is_trivially_relocatable_v<T>) {
+        DestroyN(from, n);
+    }
+}
+
+// Проверяет, ссылается ли какой-либо из аргументов на память элементов [first, last)
+// или их подобъектов. Для аргументов-указателей на объекты проверяется и адрес, на
+// который они указывают
+template <typename T, typename... Args>
+bool ArgumentsReferTo(const T* first, const T* last, const Args&... args) noexcept {
+    const auto inside = [first, last](const void* ptr) {
+        const auto* byte = static_cast<const unsigned char*>(ptr);
+        return std::less_equal<>{}(reinterpret_cast<const unsigned char*>(first), byte)
+               && std::less<>{}(byte, reinterpret_cast<const unsigned char*>(last));
+    };
+    [[maybe_unused]] const auto refers = [&inside](const auto& arg) {
+        using Arg = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_pointer_v<Arg> && std::is_object_v<std::remove_pointer_t<Arg>>) {
+            if(inside(arg)) {
+                return true;
+            }
+        }
+        return inside(std::addressof(arg));
+    };
+    return (false || ... || refers(args));
+}
+
+// Создаёт элемент в позиции pos массива data из size элементов, сдвигая элементы после
+// него на одну позицию. Память data[size] должна быть выделена.
+// Если аргументы не ссылаются на сдвигаемые элементы, элемент создаётся сразу на месте:
+// тривиально перемещаемые элементы сдвигаются memmove, остальные — перемещениями, если
+// те не выбрасывают исключений. Если конструктор элемента выбросил исключение, элементы
+// сдвигаются обратно, и массив не меняется. В остальных случаях элемент сначала создаётся
+// во временном объекте, а при исключении во время сдвига гарантия только базовая
+template <typename T, typename... Args>
+T* ShiftAndEmplace(T* data, size_t size, size_t pos, Args&&... args) {
+    assert(pos < size);
+    T* elem = data + pos;
+    const size_t tail = size - pos;
+    const bool aliased = ArgumentsReferTo<T>(elem, data + size, args...);
+    if constexpr (is_trivially_relocatable_v<T>) {
+        if(aliased) {
+            alignas(T) unsigned char storage[sizeof(T)];
+            new (storage) T(std::forward<Args>(args)...);
+            std::memmove(static_cast<void*>(elem + 1), elem, tail * sizeof(T));
+            std::memcpy(static_cast<void*>(elem), storage, sizeof(T));
+        } else {
+            std::memmove(static_cast<void*>(elem + 1), elem, tail * sizeof(T));
+            try {
+                new (elem) T(std::forward<Args>(args)...);
+            } catch (...) {
+                std::memmove(static_cast<void*>(elem), elem + 1, tail * sizeof(T));
+                throw;
+            }
+        }
+        return elem;
+    } else {
+        if constexpr (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>) {
+            if(!aliased) {
+                new (data + size) T(std::move(data[size - 1]));
+                std::move_backward(elem, data + size - 1, data + size);
+                elem->~T();
+                try {
+                    new (elem) T(std::forward<Args>(args)...);
+                } catch (...) {
+                    new (elem) T(std::move(elem[1]));
+                    std::move(elem + 2, data + size + 1, elem + 1);
+                    data[size].~T();
+                    throw;
+                }
+                return elem;
+            }
+        }
+        T temp(std::forward<Args>(args)...);
+        new (data + size) T(std::move(data[size - 1]));
+        std::move_backward(elem, data + size - 1, data + size);
+        *elem = std::move(temp);
+        return elem;
+    }
+}
+
+// Разрешает перегрузку только для итераторов, чтобы Insert(pos, count, value)
+// не путался с Insert(pos, first, last) для целочисленных T
+template <typename It>
+using RequireInputIterator = std::enable_if_t<
+    std::is_convertible_v<typename std::iterator_traits<It>::iterator_category, std::input_iterator_tag>>;
+
+template <typename It>
+inline constexpr bool is_forward_iterator_v =
+    std::is_convertible_v<typename std::iterator_traits<It>::iterator_category, std::forward_iterator_tag>;
+
+// Переносит элементы [first, last) в уже существующие элементы, начиная с dest:
+// перемещением, если оно не выбрасывает исключений, иначе копированием
+template <typename It>
+It MoveOrCopyAssign(It first, It last, It dest) {
+    using T = typename std::iterator_traits<It>::value_type;
+    if constexpr (std::is_nothrow_move_assignable_v<T>) {
+        return std::move(first, last, dest);
+    } else {
+        return std::copy(first, last, dest);
+    }
+}
+
+// Тег конструктора и функций, оставляющих новые элементы инициализированными по умолчанию:
+// для тривиальных типов память не обнуляется
+struct DefaultInit {
+    explicit DefaultInit() = default;
+};
+
+inline constexpr DefaultInit default_init{};
+
+// Параметры параллельного создания элементов в конструкторах, Resize и Assign
+struct ParallelPolicy {
+    // Количество потоков, 0 означает std::thread::hardware_concurrency()
+    size_t num_threads = 0;
+    // Объём элементов, меньше которого на отдельный поток не выделяется
+    size_t min_chunk_bytes = size_t{1} << 20;
+};
+
+inline constexpr ParallelPolicy parallel{};
+
+// Типы, принимаемые параллельными перегрузками. Сторонние политики (например,
+// std::execution::par в execution_policy.h) подключаются специализацией шаблона
+// и исполняются с параметрами ParallelPolicy по умолчанию
+template <typename Policy>
+struct is_parallel_policy : std::false_type {
+};
+
+template <>
+struct is_parallel_policy<ParallelPolicy> : std::true_type {
+};
+
+template <typename Policy>
+inline constexpr bool is_parallel_policy_v = is_parallel_policy<std::remove_cv_t<std::remove_reference_t<Policy>>>::value;
+
+template <typename Policy>
+using RequireParallelPolicy = std::enable_if_t<is_parallel_policy_v<Policy>>;
+
+template <typename Policy>
+ParallelPolicy ToParallelPolicy(const Policy& policy) noexcept {
+    if constexpr (std::is_same_v<Policy, ParallelPolicy>) {
+        return policy;
+    } else {
+        return ParallelPolicy{};
+    }
+}
+
+// Создаёт count элементов в неинициализированной памяти dst, разбивая её на непрерывные
+// части по потокам: source.Construct(dst + from, from, n) вызывается для каждой части
+// и должна либо создать все её элементы, либо разрушить созданные и выбросить исключение.
+// Часть создаётся в том потоке, который первым коснётся её страниц, поэтому при политике
+// first-touch страницы окажутся на узле NUMA потока, обрабатывающего эту часть.
+// Если какая-то часть не создана, созданные части разрушаются, и выбрасывается
+// первое из исключений
+template <typename T, typename Source>
+void ParallelConstructN(const ParallelPolicy& policy, T* dst, size_t count, const Source& source) {
+    const size_t num_threads =
+        policy.num_threads != 0 ? policy.num_threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const size_t min_chunk = std::max<size_t>(policy.min_chunk_bytes / sizeof(T), 1);
+    const size_t num_chunks = std::min(num_threads, std::max<size_t>(count / min_chunk, 1));
+    if(num_chunks <= 1) {
+        source.Construct(dst, 0, count);
+        return;
+    }
+
+    const auto chunk_begin = [count, num_chunks](size_t chunk) {
+        return count / num_chunks * chunk + std::min(chunk, count % num_chunks);
+    };
+    std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[num_chunks]);
+    std::unique_ptr<std::thread[]> threads(new std::thread[num_chunks - 1]);
+    const auto construct_chunk = [&](size_t chunk) noexcept {
+        const size_t from = chunk_begin(chunk);
+        try {
+            source.Construct(dst + from, from, chunk_begin(chunk + 1) - from);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+
+    size_t num_started = 0;
+    try {
+        for(; num_started + 1 < num_chunks; ++num_started) {
+            threads[num_started] = std::thread(construct_chunk, num_started + 1);
+        }
+    } catch (...) {
+        // Не запущенные части считаются несозданными
+        for(size_t chunk = num_started + 1; chunk < num_chunks; ++chunk) {
+            errors[chunk] = std::current_exception();
+        }
+    }
+    construct_chunk(0);
+    for(size_t i = 0; i < num_started; ++i) {
+        threads[i].join();
+    }
+
+    std::exception_ptr error;
+    for(size_t chunk = 0; chunk < num_chunks && !error; ++chunk) {
+        error = errors[chunk];
+    }
+    if(error) {
+        for(size_t chunk = 0; chunk < num_chunks; ++chunk) {
+            if(!errors[chunk]) {
+                DestroyN(dst + chunk_begin(chunk), chunk_begin(chunk + 1) - chunk_begin(chunk));
+            }
+        }
+        std::rethrow_exception(error);
+    }
+}
+
+// Гарантированное выравнивание буферов аллокатора: ALIGNMENT, если аллокатор объявляет
+// такую константу (как AlignedAllocator), иначе alignof(value_type)
+template <typename Alloc, typename = void>
+struct AllocatorAlignment : std::integral_constant<size_t, alignof(typename Alloc::value_type)> {
+};
+
+template <typename Alloc>
+struct AllocatorAlignment<Alloc, std::void_t<decltype(Alloc::ALIGNMENT)>>
+    : std::integral_constant<size_t, Alloc::ALIGNMENT> {
+};
+
+// Сообщает компилятору, что ptr выровнен по Alignment байт, чтобы он мог
+// использовать выровненные векторные инструкции
+template <size_t Alignment, typename T>
+T* AssumeAlignedPointer(T* ptr) noexcept {
+#if defined(__GNUC__)
+    return static_cast<T*>(__builtin_assume_aligned(ptr, Alignment));
+#else
+    return ptr;
+#endif
+}
+
+// Проверяет, умеет ли аллокатор изменять размер выделенного блока функцией
+// reallocate(ptr, old_n, new_n), по возможности не перемещая его
+template <typename Alloc, typename = void>
+struct HasReallocate : std::false_type {
+};
+
+template <typename Alloc>
+struct HasReallocate<Alloc, std::void_t<decltype(std::declval<Alloc&>().reallocate(
+                                std::declval<typename std::allocator_traits<Alloc>::pointer>(), size_t{}, size_t{}))>>
+    : std::true_type {
+};
+
+// Хранит аллокатор. Пустые аллокаторы (std::allocator и подобные) не занимают места
+// благодаря оптимизации пустого базового класса
+template <typename Alloc, bool = std::is_empty_v<Alloc> && !std::is_final_v<Alloc>>
+class AllocatorHolder : private Alloc {
+public:
+    AllocatorHolder() = default;
+
+    explicit AllocatorHolder(const Alloc& alloc) noexcept
+        : Alloc(alloc) {
+    }
+
+    explicit AllocatorHolder(Alloc&& alloc) noexcept
+        : Alloc(std::move(alloc)) {
+    }
+
+    Alloc& GetAllocator() noexcept {
+        return *this;
+    }
+
+    const Alloc& GetAllocator() const noexcept {
+        return *this;
+    }
+};
+
+template <typename Alloc>
+class AllocatorHolder<Alloc, false> {
+public:
+    AllocatorHolder() = default;
+
+    explicit AllocatorHolder(const Alloc& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    explicit AllocatorHolder(Alloc&& alloc) noexcept
+        : alloc_(std::move(alloc)) {
+    }
+
+    Alloc& GetAllocator() noexcept {
+        return alloc_;
+    }
+
+    const Alloc& GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+private:
+    Alloc alloc_;
+};
+
+// Освобождает память буфера, выделенного не аллокатором вектора (например, буфера,
+// принятого из сети). Хранит вызываемый объект deleter(T* buffer, size_t capacity),
+// который вызывается после разрушения всех элементов буфера. Пустой BufferDeleter
+// означает, что буфер принадлежит аллокатору
+template <typename T>
+class BufferDeleter {
+public:
+    BufferDeleter() = default;
+
+    template <typename Deleter,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<Deleter>, BufferDeleter>>>
+    explicit BufferDeleter(Deleter&& deleter)
+        : impl_(std::make_unique<Impl<std::decay_t<Deleter>>>(std::forward<Deleter>(deleter))) {
+    }
+
+    explicit operator bool() const noexcept {
+        return impl_ != nullptr;
+    }
+
+    void operator()(T* buffer, size_t capacity) noexcept {
+        impl_->Delete(buffer, capacity);
+    }
+
+private:
+    struct ImplBase {
+        virtual ~ImplBase() = default;
+        virtual void Delete(T* buffer, size_t capacity) noexcept = 0;
+    };
+
+    template <typename Deleter>
+    struct Impl : ImplBase {
+        template <typename D>
+        explicit Impl(D&& deleter) : deleter(std::forward<D>(deleter)) {
+        }
+
+        void Delete(T* buffer, size_t capacity) noexcept override {
+            deleter(buffer, capacity);
+        }
+
+        Deleter deleter;
+    };
+
+    std::unique_ptr<ImplBase> impl_;
+};
+
+template <typename T, typename Alloc = std::allocator<T>>
+class RawMemory : private AllocatorHolder<Alloc> {
+    using Holder = AllocatorHolder<Alloc>;
+    using AllocTraits = std::allocator_traits<Alloc>;
+
+    static_assert(std::is_same_v<typename AllocTraits::value_type, T>,
+                  "Alloc::value_type must be the same as T");
+
 public:
+    using allocator_type = Alloc;
+
     RawMemory() = default;
 
-    explicit RawMemory(size_t capacity)
-        : buffer_(Allocate(capacity))
+    explicit RawMemory(const Alloc& alloc) noexcept
+        : Holder(alloc) {
+    }
+
+    explicit RawMemory(size_t capacity, const Alloc& alloc = Alloc())
+        : Holder(alloc)
+        , buffer_(Allocate(capacity))
         , capacity_(capacity) {
     }
 
-    ~RawMemory() {
-        Deallocate(buffer_);
+    ~RawMemory() {
+        Deallocate(buffer_, capacity_);
+    }
+    
+    RawMemory(const RawMemory&) = delete;
+    RawMemory& operator=(const RawMemory& rhs) = delete;
+    
+    RawMemory(RawMemory&& other) noexcept
+        : Holder(std::move(other.GetAllocator()))
+        , buffer_(std::exchange(other.buffer_, nullptr))
+        , capacity_(std::exchange(other.capacity_, 0))
+        , deleter_(std::move(other.deleter_)) {
+    }
+    
+    // Обменивается буферами с rhs. Аллокатор переходит вместе с буфером, только если
+    // этого требует propagate_on_container_move_assignment
+    RawMemory& operator=(RawMemory&& rhs) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            SwapStorage(rhs);
+        } else {
+            SwapBuffers(rhs);
+        }
+        return *this;
+    }
+
+    T* operator+(size_t offset) noexcept {
+        // Разрешается получать адрес ячейки памяти, следующей за последним элементом массива
+        assert(offset <= capacity_);
+        return buffer_ + offset;
+    }
+
+    const T* operator+(size_t offset) const noexcept {
+        return const_cast<RawMemory&>(*this) + offset;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<RawMemory&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        assert(index < capacity_);
+        return buffer_[index];
+    }
+
+    // Обменивается буферами с other. Аллокаторы обмениваются, только если этого требует
+    // propagate_on_container_swap, иначе они должны быть равны
+    void Swap(RawMemory& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            SwapStorage(other);
+        } else {
+            assert(GetAllocator() == other.GetAllocator());
+            SwapBuffers(other);
+        }
+    }
+
+    // Безусловно обменивается с other и буферами, и аллокаторами
+    void SwapStorage(RawMemory& other) noexcept {
+        using std::swap;
+        swap(GetAllocator(), other.GetAllocator());
+        SwapBuffers(other);
+    }
+
+    const T* GetAddress() const noexcept {
+        return buffer_;
+    }
+
+    T* GetAddress() noexcept {
+        return buffer_;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+    using Holder::GetAllocator;
+
+    // Буфер, отданный функцией Release, вместе со способом его освобождения
+    struct ReleasedBuffer {
+        T* buffer = nullptr;
+        size_t capacity = 0;
+        BufferDeleter<T> deleter;
+    };
+
+    // Освобождает текущий буфер и принимает во владение buffer ёмкостью capacity,
+    // который будет освобождён вызовом deleter
+    void Adopt(T* buffer, size_t capacity, BufferDeleter<T> deleter) noexcept {
+        assert(buffer != nullptr || capacity == 0);
+        Deallocate(buffer_, capacity_);
+        buffer_ = buffer;
+        capacity_ = capacity;
+        deleter_ = std::move(deleter);
+    }
+
+    // Отдаёт буфер вызывающему, оставаясь без буфера. Буфер аллокатора освобождается
+    // копией аллокатора, сохранённой в deleter
+    ReleasedBuffer Release() {
+        ReleasedBuffer result;
+        if(buffer_ != nullptr && !deleter_) {
+            result.deleter = BufferDeleter<T>([alloc = GetAllocator()](T* buffer, size_t capacity) mutable {
+                AllocTraits::deallocate(alloc, buffer, capacity);
+            });
+        } else {
+            result.deleter = std::move(deleter_);
+        }
+        result.buffer = std::exchange(buffer_, nullptr);
+        result.capacity = std::exchange(capacity_, 0);
+        return result;
+    }
+
+    // Возвращает true, если буфер можно расширять функцией Reallocate
+    static constexpr bool CanReallocate() noexcept {
+        return HasReallocate<Alloc>::value && is_trivially_relocatable_v<T>;
+    }
+
+    // Изменяет ёмкость буфера средствами аллокатора, по возможности без копирования.
+    // Содержимое переносится побайтово, поэтому функция доступна только при CanReallocate()
+    void Reallocate(size_t new_capacity) {
+        static_assert(CanReallocate(), "Reallocate requires a reallocating allocator and a trivially relocatable T");
+        if(buffer_ == nullptr || new_capacity == 0 || deleter_) {
+            // Принятый извне буфер аллокатор расширить не может, его содержимое копируется
+            RawMemory new_data(new_capacity, GetAllocator());
+            if(buffer_ != nullptr && new_capacity != 0) {
+                std::memcpy(static_cast<void*>(new_data.buffer_), buffer_, std::min(capacity_, new_capacity) * sizeof(T));
+            }
+            SwapBuffers(new_data);
+            return;
+        }
+        buffer_ = GetAllocator().reallocate(buffer_, capacity_, new_capacity);
+        capacity_ = new_capacity;
+    }
+
+private:
+    // Выделяет сырую память под n элементов и возвращает указатель на неё
+    T* Allocate(size_t n) {
+        return n != 0 ? AllocTraits::allocate(GetAllocator(), n) : nullptr;
+    }
+
+    // Освобождает собственный буфер buf ёмкостью n элементов: через deleter_, если буфер
+    // принят функцией Adopt, иначе аллокатором
+    void Deallocate(T* buf, size_t n) noexcept {
+        if (buf == nullptr) {
+            return;
+        }
+        if (deleter_) {
+            deleter_(buf, n);
+        } else {
+            AllocTraits::deallocate(GetAllocator(), buf, n);
+        }
+    }
+
+    void SwapBuffers(RawMemory& other) noexcept {
+        std::swap(buffer_, other.buffer_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(deleter_, other.deleter_);
+    }
+
+    T* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    BufferDeleter<T> deleter_;
+};
+
+// Буфер с элементами, отданный вектором функцией Release. Элементы [Data(), Data() + Size())
+// живы, память рассчитана на Capacity() элементов. Разрушает элементы и освобождает память,
+// если не передан обратно в вектор функцией Vector::Adopt
+template <typename T>
+class OwnedBuffer {
+public:
+    OwnedBuffer() = default;
+
+    OwnedBuffer(T* data, size_t size, size_t capacity, BufferDeleter<T> deleter) noexcept
+        : data_(data), size_(size), capacity_(capacity), deleter_(std::move(deleter)) {
+    }
+
+    OwnedBuffer(const OwnedBuffer&) = delete;
+    OwnedBuffer& operator=(const OwnedBuffer&) = delete;
+
+    OwnedBuffer(OwnedBuffer&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , capacity_(std::exchange(other.capacity_, 0))
+        , deleter_(std::move(other.deleter_)) {
+    }
+
+    OwnedBuffer& operator=(OwnedBuffer&& rhs) noexcept {
+        if(this != &rhs) {
+            OwnedBuffer old(std::move(*this));
+            std::swap(data_, rhs.data_);
+            std::swap(size_, rhs.size_);
+            std::swap(capacity_, rhs.capacity_);
+            std::swap(deleter_, rhs.deleter_);
+        }
+        return *this;
+    }
+
+    ~OwnedBuffer() {
+        if(data_ != nullptr) {
+            DestroyN(data_, size_);
+            if(deleter_) {
+                deleter_(data_, capacity_);
+            }
+        }
+    }
+
+    T* Data() const noexcept {
+        return data_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return capacity_;
+    }
+
+    // Отказывается от владения без разрушения элементов и возвращает способ освобождения
+    // памяти. Нужна, чтобы передать буфер другому владельцу
+    BufferDeleter<T> Detach() noexcept {
+        data_ = nullptr;
+        size_ = capacity_ = 0;
+        return std::move(deleter_);
+    }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    BufferDeleter<T> deleter_;
+};
+
+
+// Политики роста определяют ёмкость нового буфера, когда в текущем не осталось места.
+// NextCapacity получает текущую ёмкость, минимально необходимую ёмкость и размер элемента
+// в байтах и возвращает новую ёмкость, не меньшую required
+
+// Геометрический рост с коэффициентом Num / Den. Первый буфер вмещает не менее MinCapacity
+// элементов, что избавляет маленькие векторы от серии выделений 1, 2, 4, 8...
+template <size_t Num, size_t Den, size_t MinCapacity = 1>
+struct GeometricGrowth {
+    static_assert(Num > Den && Den > 0, "Growth factor must be greater than 1");
+    static_assert(MinCapacity > 0, "Minimal capacity must be positive");
+
+    static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t /*element_size*/) noexcept {
+        const size_t grown = capacity == 0 ? MinCapacity : std::max(capacity * Num / Den, capacity + 1);
+        return std::max(grown, required);
+    }
+};
+
+// Удвоение ёмкости, начиная с одного элемента
+using DoublingGrowth = GeometricGrowth<2, 1>;
+
+// Рост в полтора раза: оставляет меньше неиспользуемой ёмкости у больших векторов
+using HalfGrowth = GeometricGrowth<3, 2>;
+
+// Растёт по политике Base, пока буфер меньше ThresholdBytes байт, а затем линейно,
+// добавляя по StepBytes байт, чтобы огромные векторы не держали гигабайты пустой ёмкости
+template <size_t ThresholdBytes, size_t StepBytes, typename Base = DoublingGrowth>
+struct LinearAboveThresholdGrowth {
+    static_assert(StepBytes > 0, "Growth step must be positive");
+
+    static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept {
+        if(capacity * element_size < ThresholdBytes) {
+            return Base::NextCapacity(capacity, required, element_size);
+        }
+        const size_t step = std::max<size_t>(StepBytes / element_size, 1);
+        return std::max(capacity + step, required);
+    }
+};
+
+// Округляет ёмкость, выбранную политикой Base, вверх до границы класса размеров
+// распределителя памяти: до 16 байт, а дальше четыре класса на каждую степень двойки,
+// как в jemalloc и tcmalloc. Распределитель всё равно выделил бы блок такого размера
+// (его вернул бы malloc_usable_size), так что вектор использует этот хвост как ёмкость
+template <typename Base = DoublingGrowth>
+struct SizeClassGrowth {
+    static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept {
+        const size_t new_capacity = Base::NextCapacity(capacity, required, element_size);
+        return RoundUpToSizeClass(new_capacity * element_size) / element_size;
+    }
+
+    static constexpr size_t RoundUpToSizeClass(size_t bytes) noexcept {
+        if(bytes <= 16) {
+            return 16;
+        }
+        size_t highest_bit = 0;
+        for(size_t rest = bytes - 1; rest > 1; rest >>= 1) {
+            ++highest_bit;
+        }
+        const size_t spacing = std::max<size_t>(16, size_t{1} << (highest_bit - 2));
+        return (bytes + spacing - 1) / spacing * spacing;
+    }
+};
+
+// Политика роста может дополнительно определить ShrinkCapacity(size, capacity, element_size),
+// возвращающую ёмкость, до которой вектор сам уменьшит буфер после удаления элементов.
+// Возврат capacity означает, что буфер остаётся прежним
+template <typename Growth, typename = void>
+struct HasShrinkCapacity : std::false_type {
+};
+
+template <typename Growth>
+struct HasShrinkCapacity<Growth, std::void_t<decltype(Growth::ShrinkCapacity(size_t{}, size_t{}, size_t{}))>>
+    : std::true_type {
+};
+
+// Растёт по политике Base и уменьшает буфер вдвое больше размера, когда размер падает
+// ниже Capacity / Divisor. Зазор между порогами роста и уменьшения не даёт вектору
+// перераспределять память при колебаниях размера возле границы
+template <typename Base = DoublingGrowth, size_t Divisor = 4>
+struct AutoShrinkGrowth {
+    static_assert(Divisor > 2, "Shrink threshold must leave room for hysteresis");
+
+    static constexpr size_t NextCapacity(size_t capacity, size_t required, size_t element_size) noexcept {
+        return Base::NextCapacity(capacity, required, element_size);
+    }
+
+    static constexpr size_t ShrinkCapacity(size_t size, size_t capacity, size_t /*element_size*/) noexcept {
+        return size < capacity / Divisor ? size * 2 : capacity;
+    }
+};
+
+// Политика учёта статистики по умолчанию: ничего не записывает и не занимает места.
+// Vector создаёт Probe<T> перед каждой сменой буфера и вызывает Commit после её успешного
+// завершения, а отказываясь от буфера (при разрушении, присваивании, ClearAndRelease, Release
+// и Adopt) сообщает политике его размер и ёмкость через OnRelease.
+// Собирающая статистику политика VectorStats определена в vector_stats.h
+struct NoVectorStats {
+    template <typename T>
+    struct Probe {
+        void Commit(size_t /*old_capacity*/, size_t /*new_capacity*/, size_t /*moved*/) noexcept {
+        }
+    };
+
+    template <typename T>
+    static void OnRelease(size_t /*size*/, size_t /*capacity*/) noexcept {
+    }
+};
+
+// Политики проверок определяют, что Vector проверяет в операциях с элементами.
+// CHECK_BOUNDS включает проверку индексов operator[] и позиций, переданных Insert, Emplace
+// и Erase. CHECK_ITERATORS делает итераторы вектора объектами CheckedIterator: итератор
+// помнит вектор и поколение его буфера, которое увеличивается при каждой смене буфера
+// (Reserve, рост, уменьшение, Swap, перемещение), и проверяет их при каждом обращении.
+// Нарушение передаётся VectorCheckFailed, которая вынесена из горячего пути
+
+// Без проверок, кроме assert в отладочной сборке. Политика по умолчанию
+struct NoVectorChecks {
+    static constexpr bool CHECK_BOUNDS = false;
+    static constexpr bool CHECK_ITERATORS = false;
+};
+
+// Проверка индексов и позиций при сохранении итераторов-указателей
+struct BoundsVectorChecks {
+    static constexpr bool CHECK_BOUNDS = true;
+    static constexpr bool CHECK_ITERATORS = false;
+};
+
+// Проверка индексов, позиций и итераторов
+struct DebugVectorChecks {
+    static constexpr bool CHECK_BOUNDS = true;
+    static constexpr bool CHECK_ITERATORS = true;
+};
+
+// Обработчик нарушения проверки получает его описание. Если обработчик вернёт управление,
+// программа завершается вызовом std::abort
+using VectorCheckHandler = void (*)(const char* message);
+
+#if defined(__GNUC__)
+#define VECTOR_CHECK_COLD __attribute__((cold, noinline))
+#else
+#define VECTOR_CHECK_COLD
+#endif
+
+namespace vector_checks_detail {
+
+inline void PrintCheckFailure(const char* message) {
+    std::cerr << "Vector check failed: " << message << std::endl;
+}
+
+inline std::atomic<VectorCheckHandler>& CheckHandler() noexcept {
+    static std::atomic<VectorCheckHandler> handler{&PrintCheckFailure};
+    return handler;
+}
+
+// Поколение буфера хранится только у векторов с проверкой итераторов
+template <bool Enabled>
+struct IteratorGeneration {
+    void InvalidateIterators() noexcept {
+    }
+};
+
+template <>
+struct IteratorGeneration<true> {
+    void InvalidateIterators() noexcept {
+        ++generation_;
+    }
+
+    uint64_t generation_ = 0;
+};
+
+}  // namespace vector_checks_detail
+
+// Устанавливает обработчик нарушений и возвращает прежний. nullptr восстанавливает
+// обработчик по умолчанию, печатающий описание в std::cerr
+inline VectorCheckHandler SetVectorCheckHandler(VectorCheckHandler handler) noexcept {
+    return vector_checks_detail::CheckHandler().exchange(
+        handler != nullptr ? handler : &vector_checks_detail::PrintCheckFailure);
+}
+
+[[noreturn]] VECTOR_CHECK_COLD inline void VectorCheckFailed(const char* message) noexcept {
+    try {
+        vector_checks_detail::CheckHandler().load()(message);
+    } catch (...) {
+    }
+    std::abort();
+}
+
+// Итератор вектора Owner с политикой CHECK_ITERATORS. Разыменование, сдвиг и сравнение
+// проверяют, что буфер вектора не сменился после создания итератора и что позиция
+// не выходит за пределы элементов. Итератор не должен пережить свой вектор
+template <typename Owner, typename T>
+class CheckedIterator {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_const_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    CheckedIterator() = default;
+
+    // Итератор изменяемых элементов преобразуется в итератор константных
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_const_v<U>>>
+    CheckedIterator(const CheckedIterator<Owner, U>& other) noexcept
+        : owner_(other.owner_)
+        , generation_(other.generation_)
+        , ptr_(other.ptr_) {
+    }
+
+    reference operator*() const noexcept {
+        return *CheckedAt(0);
+    }
+
+    pointer operator->() const noexcept {
+        return CheckedAt(0);
+    }
+
+    reference operator[](difference_type n) const noexcept {
+        return *CheckedAt(n);
+    }
+
+    CheckedIterator& operator++() noexcept {
+        return *this += 1;
+    }
+
+    CheckedIterator operator++(int) noexcept {
+        CheckedIterator result = *this;
+        *this += 1;
+        return result;
+    }
+
+    CheckedIterator& operator--() noexcept {
+        return *this -= 1;
+    }
+
+    CheckedIterator operator--(int) noexcept {
+        CheckedIterator result = *this;
+        *this -= 1;
+        return result;
+    }
+
+    CheckedIterator& operator+=(difference_type n) noexcept {
+        if(Offset() + n > owner_->size_) {
+            VectorCheckFailed("Iterator is moved out of range");
+        }
+        ptr_ += n;
+        return *this;
+    }
+
+    CheckedIterator& operator-=(difference_type n) noexcept {
+        return *this += -n;
     }
-    
-    RawMemory(const RawMemory&) = delete;
-    RawMemory& operator=(const RawMemory& rhs) = delete;
-    
-    RawMemory(RawMemory&& other) noexcept {
-        Swap(other);
+
+    friend CheckedIterator operator+(CheckedIterator it, difference_type n) noexcept {
+        return it += n;
     }
-    
-    RawMemory& operator=(RawMemory&& rhs) noexcept {
-        Swap(rhs);
-        return *this;
+
+    friend CheckedIterator operator+(difference_type n, CheckedIterator it) noexcept {
+        return it += n;
     }
 
-    T* operator+(size_t offset) noexcept {
-        // Разрешается получать адрес ячейки памяти, следующей за последним элементом массива
-        assert(offset <= capacity_);
-        return buffer_ + offset;
+    friend CheckedIterator operator-(CheckedIterator it, difference_type n) noexcept {
+        return it -= n;
     }
 
-    const T* operator+(size_t offset) const noexcept {
-        return const_cast<RawMemory&>(*this) + offset;
+    friend difference_type operator-(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        lhs.CheckComparable(rhs);
+        return lhs.ptr_ - rhs.ptr_;
     }
 
-    const T& operator[](size_t index) const noexcept {
-        return const_cast<RawMemory&>(*this)[index];
+    friend bool operator==(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        lhs.CheckComparable(rhs);
+        return lhs.ptr_ == rhs.ptr_;
     }
 
-    T& operator[](size_t index) noexcept {
-        assert(index < capacity_);
-        return buffer_[index];
+    friend bool operator!=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return !(lhs == rhs);
     }
 
-    void Swap(RawMemory& other) noexcept {
-        std::swap(buffer_, other.buffer_);
-        std::swap(capacity_, other.capacity_);
+    friend bool operator<(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        lhs.CheckComparable(rhs);
+        return lhs.ptr_ < rhs.ptr_;
     }
 
-    const T* GetAddress() const noexcept {
-        return buffer_;
+    friend bool operator>(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return rhs < lhs;
     }
 
-    T* GetAddress() noexcept {
-        return buffer_;
+    friend bool operator<=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return !(rhs < lhs);
     }
 
-    size_t Capacity() const {
-        return capacity_;
+    friend bool operator>=(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        return !(lhs < rhs);
     }
 
 private:
-    // Выделяет сырую память под n элементов и возвращает указатель на неё
-    static T* Allocate(size_t n) {
-        return n != 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+    template <typename, typename>
+    friend class CheckedIterator;
+    friend Owner;
+
+    CheckedIterator(const Owner* owner, T* ptr) noexcept
+        : owner_(owner)
+        , generation_(owner->generation_)
+        , ptr_(ptr) {
     }
 
-    // Освобождает сырую память, выделенную ранее по адресу buf при помощи Allocate
-    static void Deallocate(T* buf) noexcept {
-        operator delete(buf);
+    // Номер позиции итератора. Итератор должен принадлежать вектору и не устареть
+    size_t Offset() const noexcept {
+        if(owner_ == nullptr || generation_ != owner_->generation_) {
+            VectorCheckFailed("Iterator is invalidated or singular");
+        }
+        return static_cast<size_t>(ptr_ - owner_->data_.GetAddress());
     }
 
-    T* buffer_ = nullptr;
-    size_t capacity_ = 0;
+    // Отрицательный сдвиг за начало превращается в огромный номер и тоже отвергается
+    T* CheckedAt(difference_type n) const noexcept {
+        if(Offset() + n >= owner_->size_) {
+            VectorCheckFailed("Dereferenced iterator is out of range");
+        }
+        return ptr_ + n;
+    }
+
+    void CheckComparable(const CheckedIterator& other) const noexcept {
+        if(owner_ != other.owner_) {
+            VectorCheckFailed("Iterators of different vectors are compared");
+        }
+        if(owner_ != nullptr) {
+            Offset();
+            other.Offset();
+        }
+    }
+
+    const Owner* owner_ = nullptr;
+    uint64_t generation_ = 0;
+    T* ptr_ = nullptr;
 };
 
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth,
+          typename Stats = NoVectorStats, typename Checks = NoVectorChecks>
+class Vector : private vector_checks_detail::IteratorGeneration<Checks::CHECK_ITERATORS> {
+    using AllocTraits = std::allocator_traits<Alloc>;
+    using StatsProbe = typename Stats::template Probe<T>;
+
+    template <typename, typename>
+    friend class CheckedIterator;
 
-template <typename T>
-class Vector {
 public:
-    using iterator = T*;
-    using const_iterator = const T*;
+    using iterator = std::conditional_t<Checks::CHECK_ITERATORS, CheckedIterator<Vector, T>, T*>;
+    using const_iterator = std::conditional_t<Checks::CHECK_ITERATORS, CheckedIterator<Vector, const T>, const T*>;
+    using allocator_type = Alloc;
+    using growth_policy = Growth;
+    using stats_policy = Stats;
+    using check_policy = Checks;
+
+    // Выравнивание, которое обещает AssumeAligned
+    static constexpr size_t ALIGNMENT = AllocatorAlignment<Alloc>::value;
     
     Vector() = default;
+
+    explicit Vector(const Alloc& alloc) noexcept : data_(alloc) {
+    }
     
-    explicit Vector(size_t size) : data_(size), size_(size) {
+    explicit Vector(size_t size, const Alloc& alloc = Alloc()) : data_(size, alloc), size_(size) {
         std::uninitialized_value_construct_n(data_.GetAddress(), size);
     }
+
+    // Создаёт size элементов, инициализированных по умолчанию. Память под элементы
+    // тривиальных типов не заполняется и должна быть перезаписана пользователем
+    Vector(size_t size, DefaultInit, const Alloc& alloc = Alloc()) : data_(size, alloc), size_(size) {
+        std::uninitialized_default_construct_n(data_.GetAddress(), size);
+    }
+    
+    // Параллельные варианты конструкторов создают элементы в нескольких потоках
+    template <typename Policy, typename = RequireParallelPolicy<Policy>>
+    Vector(const Policy& policy, size_t size, const Alloc& alloc = Alloc()) : data_(size, alloc) {
+        ParallelConstructN(ToParallelPolicy(policy), data_.GetAddress(), size, ValueInitSource{});
+        size_ = size;
+    }
+
+    template <typename Policy, typename = RequireParallelPolicy<Policy>>
+    Vector(const Policy& policy, size_t size, DefaultInit, const Alloc& alloc = Alloc()) : data_(size, alloc) {
+        ParallelConstructN(ToParallelPolicy(policy), data_.GetAddress(), size, DefaultInitSource{});
+        size_ = size;
+    }
+
+    template <typename Policy, typename = RequireParallelPolicy<Policy>>
+    Vector(const Policy& policy, const Vector& other)
+        : Vector(policy, other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
+    }
+
+    template <typename Policy, typename = RequireParallelPolicy<Policy>>
+    Vector(const Policy& policy, const Vector& other, const Alloc& alloc) : data_(other.size_, alloc) {
+        ParallelConstructN(ToParallelPolicy(policy), data_.GetAddress(), other.size_,
+                           RangeSource<const T*>{other.data_.GetAddress()});
+        size_ = other.size_;
+    }
     
-    Vector(const Vector& other) : data_(other.size_), size_(other.size_) {
-        std::uninitialized_copy_n(other.data_.GetAddress(), other.size_, data_.GetAddress());
+    Vector(const Vector& other)
+        : Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
+    }
+
+    Vector(const Vector& other, const Alloc& alloc) : data_(other.size_, alloc), size_(other.size_) {
+        RangeSource<const T*>{other.data_.GetAddress()}.Construct(data_.GetAddress(), 0, size_);
     }
     
     Vector(Vector&& other) noexcept : data_(std::move(other.data_)), size_(other.size_) {
         other.size_ = 0;
+        other.InvalidateIterators();
+    }
+
+    // Если alloc не равен аллокатору other, буфер не может быть заимствован,
+    // и элементы перемещаются поэлементно
+    Vector(Vector&& other, const Alloc& alloc) : data_(alloc) {
+        if (alloc == other.GetAllocator()) {
+            data_.Swap(other.data_);
+            std::swap(size_, other.size_);
+            other.InvalidateIterators();
+        } else {
+            RawMemory<T, Alloc> new_data(other.size_, alloc);
+            std::uninitialized_move_n(other.data_.GetAddress(), other.size_, new_data.GetAddress());
+            data_.Swap(new_data);
+            size_ = other.size_;
+        }
     }
 
+    // Если элементы rhs не помещаются в буфер, они копируются в новый буфер ровно на
+    // rhs.Size() элементов, и при исключении вектор не меняется. Иначе существующие элементы
+    // переприсваиваются, недостающие создаются в свободной части буфера. Тривиально
+    // копируемые элементы копируются memcpy
     Vector& operator=(const Vector& rhs) {
         if(this != &rhs) {
-            if(rhs.size_ > data_.Capacity()) {
-                Vector rhs_copy(rhs);
-                Swap(rhs_copy);
+            constexpr bool propagate = AllocTraits::propagate_on_container_copy_assignment::value;
+            const bool foreign_allocator = propagate && GetAllocator() != rhs.GetAllocator();
+            const RangeSource<const T*> source{rhs.data_.GetAddress()};
+            if(foreign_allocator || rhs.size_ > data_.Capacity()) {
+                // Память, выделенную текущим аллокатором, нельзя освободить аллокатором rhs
+                RawMemory<T, Alloc> new_data(rhs.size_, foreign_allocator ? rhs.GetAllocator() : GetAllocator());
+                source.Construct(new_data.GetAddress(), 0, rhs.size_);
+                Stats::template OnRelease<T>(size_, data_.Capacity());
+                DestroyN(data_.GetAddress(), size_);
+                data_.SwapStorage(new_data);
+                InvalidateIterators();
+            } else if(rhs.size_ < size_) {
+                source.Assign(data_.GetAddress(), 0, rhs.size_);
+                DestroyN(data_ + rhs.size_, size_ - rhs.size_);
             } else {
-                if(rhs.size_ < size_) {
-                    std::copy(rhs.begin(), rhs.begin() + rhs.size_, begin());
-                    std::destroy_n(data_ + rhs.size_, size_ - rhs.size_);
-                }
-                if(rhs.size_ >= size_) {
-                    std::copy(rhs.begin(), rhs.begin() + size_, begin());
-                    std::uninitialized_copy_n(rhs.data_ + size_, rhs.size_ - size_, data_.GetAddress());
-                }
-                size_ = rhs.size_;
+                source.Assign(data_.GetAddress(), 0, size_);
+                source.Construct(data_ + size_, size_, rhs.size_ - size_);
             }
+            size_ = rhs.size_;
         }
         return *this;
     }
     
-    Vector& operator=(Vector&& rhs) noexcept {
+    // Забирает буфер rhs за O(1): прежние элементы вектора разрушаются, его прежний буфер
+    // освобождается, rhs остаётся пустым и без буфера
+    Vector& operator=(Vector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                             || AllocTraits::is_always_equal::value) {
         if(this != &rhs) {
-            if(rhs.size_ > data_.Capacity()) {
-                Vector rhs_copy(std::move(rhs));
-                Swap(rhs_copy);
-            } else {
-                data_ = std::move(rhs.data_);
-                size_ = rhs.size_;
+            if constexpr (!AllocTraits::propagate_on_container_move_assignment::value
+                          && !AllocTraits::is_always_equal::value) {
+                if(GetAllocator() != rhs.GetAllocator()) {
+                    // Чужой буфер заимствовать нельзя, перемещаем элементы в память своего аллокатора
+                    Vector rhs_copy(std::move(rhs), GetAllocator());
+                    Swap(rhs_copy);
+                    return *this;
+                }
             }
+            data_ = std::move(rhs.data_);
+            std::swap(size_, rhs.size_);
+            InvalidateIterators();
+            // Прежние элементы и буфер перешли к rhs и освобождаются тем аллокатором, что
+            // выделил буфер: при распространении аллокатора он перешёл к rhs вместе с буфером
+            rhs.ClearAndRelease();
         }
         return *this;
     }
 
+    // Если propagate_on_container_swap ложно, аллокаторы векторов должны быть равны
     void Swap(Vector& other) noexcept {
         data_.Swap(other.data_);
         std::swap(size_, other.size_);
+        InvalidateIterators();
+        other.InvalidateIterators();
+    }
+
+    Alloc GetAllocator() const noexcept {
+        return data_.GetAllocator();
     }
     
     void Reserve(size_t new_capacity) {
-        if(new_capacity < data_.Capacity()) {
+        if(new_capacity <= data_.Capacity()) {
             return;
         }
-        RawMemory<T> new_data(new_capacity);
-        Uninitialized(data_.GetAddress(), size_, new_data.GetAddress());
-        DestroyAndSwap(new_data);
+        StatsProbe probe;
+        const size_t old_capacity = data_.Capacity();
+        if constexpr (RawMemory<T, Alloc>::CanReallocate()) {
+            data_.Reallocate(new_capacity);
+            InvalidateIterators();
+        } else {
+            RawMemory<T, Alloc> new_data(new_capacity, data_.GetAllocator());
+            UninitializedTransferN(data_.GetAddress(), size_, new_data.GetAddress());
+            DestroyAndSwap(new_data);
+        }
+        probe.Commit(old_capacity, new_capacity, size_);
     }
     
     void Resize(size_t new_size) {
         if(new_size < size_) {
-            std::destroy_n(data_ + new_size, size_ - new_size);
+            DestroyN(data_ + new_size, size_ - new_size);
             size_ = new_size;
+            AutoShrink();
         }
         if(new_size > size_) {
             Reserve(new_size);
@@ -164,18 +1170,87 @@ public:
             size_ = new_size;
         }
     }
+
+    // Как Resize, но новые элементы создаются в нескольких потоках
+    template <typename Policy, typename = RequireParallelPolicy<Policy>>
+    void Resize(const Policy& policy, size_t new_size) {
+        if(new_size <= size_) {
+            Resize(new_size);
+            return;
+        }
+        Reserve(new_size);
+        ParallelConstructN(ToParallelPolicy(policy), data_ + size_, new_size - size_, ValueInitSource{});
+        size_ = new_size;
+    }
+
+    // Как Resize, но новые элементы инициализируются по умолчанию, а не значением
+    void ResizeDefaultInit(size_t new_size) {
+        if(new_size < size_) {
+            DestroyN(data_ + new_size, size_ - new_size);
+            size_ = new_size;
+            AutoShrink();
+        }
+        if(new_size > size_) {
+            Reserve(new_size);
+            std::uninitialized_default_construct_n(data_ + size_, new_size - size_);
+            size_ = new_size;
+        }
+    }
+
+    // Увеличивает размер до new_size элементов, инициализированных по умолчанию, и вызывает
+    // op(data, new_size). Операция заполняет элементы напрямую (например, чтением из сокета)
+    // и возвращает итоговый размер, не превышающий new_size. Лишние элементы разрушаются.
+    // Если op выбрасывает исключение, размер вектора восстанавливается
+    template <typename Operation>
+    void ResizeAndOverwrite(size_t new_size, Operation op) {
+        const size_t old_size = size_;
+        if(new_size > size_) {
+            Reserve(new_size);
+            std::uninitialized_default_construct_n(data_ + size_, new_size - size_);
+        }
+        size_ = std::max(old_size, new_size);
+        size_t result_size = 0;
+        try {
+            result_size = static_cast<size_t>(std::move(op)(data_.GetAddress(), new_size));
+        } catch (...) {
+            DestroyN(data_ + old_size, size_ - old_size);
+            size_ = old_size;
+            throw;
+        }
+        assert(result_size <= new_size);
+        DestroyN(data_ + result_size, size_ - result_size);
+        size_ = result_size;
+    }
+    
+    // Свободная ёмкость буфера: Capacity() - Size() неинициализированных элементов после
+    // последнего. Источник данных (read, readv, io_uring) может записать в неё элементы
+    // тривиально копируемого типа, и CommitAppend сделает их частью вектора.
+    // Указатель действителен до смены буфера
+    T* SpareCapacity() noexcept {
+        return data_ + size_;
+    }
+
+    // Добавляет в вектор первые count элементов, записанных в SpareCapacity()
+    void CommitAppend(size_t count) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable elements can be written in place");
+        if constexpr (Checks::CHECK_BOUNDS) {
+            if(count > data_.Capacity() - size_) {
+                VectorCheckFailed("Committed elements exceed spare capacity");
+            }
+        } else {
+            assert(count <= data_.Capacity() - size_);
+        }
+        size_ += count;
+    }
     
     template <typename... Args>
     iterator Emplace(const_iterator pos, Args&&... args) {
-        if(size_ == data_.Capacity()) {
-            return ReallocationEmplace(pos, std::forward<Args>(args)...);
-        }
-        return NoReallocationEmplace(pos, std::forward<Args>(args)...);
+        return MakeIterator(EmplaceAt(PositionOf(pos, true), std::forward<Args>(args)...));
     }
     
     template <typename... Args>
     T& EmplaceBack(Args&&... args) {
-        return *Emplace(end(), std::forward<Args>(args)...);
+        return *EmplaceAt(size_, std::forward<Args>(args)...);
     }
     
     void PushBack(const T& value) {
@@ -183,32 +1258,55 @@ public:
     }
     
     void PushBack(T&& value) {
-        if(size_ == data_.Capacity()) {
-            RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-            new (new_data + size_) T(std::move(value));
-            Uninitialized(data_.GetAddress(), size_, new_data.GetAddress());
-            DestroyAndSwap(new_data);
-            ++size_;
-            return;
-        }
-        new (data_ + size_) T(std::move(value));
-        ++size_;
+        EmplaceBack(std::move(value));
     }
     
     void PopBack() noexcept {
-        std::destroy_n(end() - 1, 1);
+        if constexpr (Checks::CHECK_BOUNDS) {
+            if(size_ == 0) {
+                VectorCheckFailed("PopBack from empty vector");
+            }
+        }
+        DestroyN(data_ + size_ - 1, 1);
         --size_;
+        AutoShrink();
     }
     
     iterator Erase(const_iterator pos) noexcept {
-        iterator no_const_pos = const_cast<iterator>(pos);
-        if constexpr (std::is_nothrow_move_assignable_v<T>) {
-            std::move(no_const_pos + 1, end(), no_const_pos);
-        } else {
-            std::copy(no_const_pos + 1, end(), no_const_pos);
+        const size_t offset = PositionOf(pos, false);
+        T* erased = data_ + offset;
+        MoveOrCopyAssign(erased + 1, data_ + size_, erased);
+        PopBack();
+        return MakeIterator(data_ + offset);
+    }
+
+    // Удаляет элементы [first, last), сдвигая хвост один раз
+    iterator Erase(const_iterator first, const_iterator last) noexcept {
+        const size_t offset = PositionOf(first, true);
+        const size_t last_offset = PositionOf(last, true);
+        if constexpr (Checks::CHECK_BOUNDS) {
+            if(offset > last_offset) {
+                VectorCheckFailed("Erased range is reversed");
+            }
+        }
+        if(offset != last_offset) {
+            T* new_end = MoveOrCopyAssign(data_ + last_offset, data_ + size_, data_ + offset);
+            DestroyN(new_end, data_ + size_ - new_end);
+            size_ = new_end - data_.GetAddress();
+            AutoShrink();
+        }
+        return MakeIterator(data_ + offset);
+    }
+
+    // Удаляет элемент pos за O(1), переставляя на его место последний элемент.
+    // Порядок остальных элементов не сохраняется
+    iterator SwapErase(const_iterator pos) noexcept {
+        const size_t offset = PositionOf(pos, false);
+        if(offset != size_ - 1) {
+            MoveOrCopyAssign(data_ + size_ - 1, data_ + size_, data_ + offset);
         }
         PopBack();
-        return no_const_pos;
+        return MakeIterator(data_ + offset);
     }
     
     iterator Insert(const_iterator pos, const T& value) {
@@ -218,6 +1316,152 @@ public:
     iterator Insert(const_iterator pos, T&& value) {
         return Emplace(pos, std::move(value));
     }
+
+    // Вставляет элементы диапазона [first, last) перед pos. Итоговый размер вычисляется
+    // заранее, поэтому память перераспределяется не более одного раза, а хвост вектора
+    // сдвигается ровно один раз. Диапазон не должен указывать на элементы самого вектора
+    template <typename InputIt, typename = RequireInputIterator<InputIt>>
+    iterator Insert(const_iterator pos, InputIt first, InputIt last) {
+        const size_t offset = PositionOf(pos, true);
+        if constexpr (is_forward_iterator_v<InputIt>) {
+            const size_t count = static_cast<size_t>(std::distance(first, last));
+            return MakeIterator(InsertN(offset, count, RangeSource<InputIt>{first}));
+        } else if(offset == size_) {
+            for(; first != last; ++first) {
+                EmplaceBack(*first);
+            }
+            return MakeIterator(data_ + offset);
+        } else {
+            // Однопроходный диапазон нельзя измерить заранее, поэтому он сначала собирается целиком
+            Vector buffer(GetAllocator());
+            for(; first != last; ++first) {
+                buffer.EmplaceBack(*first);
+            }
+            const auto moved = std::make_move_iterator(buffer.data_.GetAddress());
+            return MakeIterator(InsertN(offset, buffer.size_, RangeSource<decltype(moved)>{moved}));
+        }
+    }
+
+    // Вставляет count копий value перед pos
+    iterator Insert(const_iterator pos, size_t count, const T& value) {
+        const size_t offset = PositionOf(pos, true);
+        if(size_ + count <= data_.Capacity() || RawMemory<T, Alloc>::CanReallocate()) {
+            // value может ссылаться на элемент вектора, который будет сдвинут или перенесён
+            const T value_copy(value);
+            return MakeIterator(InsertN(offset, count, FillSource{value_copy}));
+        }
+        return MakeIterator(InsertN(offset, count, FillSource{value}));
+    }
+
+    // Добавляет элементы range в конец вектора
+    template <typename Range>
+    void Append(const Range& range) {
+        Insert(cend(), std::begin(range), std::end(range));
+    }
+
+    // Заменяет содержимое вектора элементами диапазона [first, last)
+    template <typename InputIt, typename = RequireInputIterator<InputIt>>
+    void Assign(InputIt first, InputIt last) {
+        if constexpr (is_forward_iterator_v<InputIt>) {
+            const size_t count = static_cast<size_t>(std::distance(first, last));
+            AssignN(count, RangeSource<InputIt>{first});
+        } else {
+            Clear();
+            Insert(cend(), first, last);
+        }
+    }
+
+    // Заменяет содержимое вектора count копиями value
+    void Assign(size_t count, const T& value) {
+        const T value_copy(value);
+        AssignN(count, FillSource{value_copy});
+    }
+
+    // Как Assign(count, value), но элементы создаются в нескольких потоках. Если создание
+    // выбросило исключение и count не превышает ёмкость, вектор остаётся пустым: прежние
+    // элементы разрушаются до создания новых. Если же потребовался новый буфер, вектор
+    // остаётся прежним
+    template <typename Policy, typename = RequireParallelPolicy<Policy>>
+    void Assign(const Policy& policy, size_t count, const T& value) {
+        const T value_copy(value);
+        if(count > data_.Capacity()) {
+            RawMemory<T, Alloc> new_data(count, data_.GetAllocator());
+            ParallelConstructN(ToParallelPolicy(policy), new_data.GetAddress(), count, FillSource{value_copy});
+            Stats::template OnRelease<T>(size_, data_.Capacity());
+            DestroyN(data_.GetAddress(), size_);
+            data_.Swap(new_data);
+            InvalidateIterators();
+        } else {
+            Clear();
+            ParallelConstructN(ToParallelPolicy(policy), data_.GetAddress(), count, FillSource{value_copy});
+        }
+        size_ = count;
+    }
+
+    // Заменяет содержимое вектора элементами range
+    template <typename Range>
+    void Assign(const Range& range) {
+        Assign(std::begin(range), std::end(range));
+    }
+
+    // Разрушает все элементы, сохраняя ёмкость (даже при политике с автоматическим уменьшением)
+    void Clear() noexcept {
+        DestroyN(data_.GetAddress(), size_);
+        size_ = 0;
+    }
+
+    // Разрушает все элементы и освобождает буфер
+    void ClearAndRelease() noexcept {
+        Stats::template OnRelease<T>(size_, data_.Capacity());
+        Clear();
+        RawMemory<T, Alloc> empty_data(data_.GetAllocator());
+        data_.Swap(empty_data);
+        InvalidateIterators();
+    }
+
+    // Заменяет содержимое вектора буфером data ёмкостью capacity, первые size элементов
+    // которого уже созданы, без копирования. Когда буфер станет не нужен (при разрушении
+    // вектора или переезде в буфер большей ёмкости), его элементы будут разрушены,
+    // а память освобождена вызовом deleter(data, capacity)
+    template <typename Deleter>
+    void Adopt(T* data, size_t size, size_t capacity, Deleter&& deleter) {
+        assert(size <= capacity);
+        BufferDeleter<T> buffer_deleter(std::forward<Deleter>(deleter));
+        Stats::template OnRelease<T>(size_, data_.Capacity());
+        Clear();
+        data_.Adopt(data, capacity, std::move(buffer_deleter));
+        size_ = size;
+        InvalidateIterators();
+    }
+
+    // Принимает буфер, отданный Release этим или другим вектором
+    void Adopt(OwnedBuffer<T>&& buffer) noexcept {
+        OwnedBuffer<T> owned(std::move(buffer));
+        Stats::template OnRelease<T>(size_, data_.Capacity());
+        Clear();
+        T* data = owned.Data();
+        const size_t size = owned.Size();
+        const size_t capacity = owned.Capacity();
+        data_.Adopt(data, capacity, owned.Detach());
+        size_ = size;
+        InvalidateIterators();
+    }
+
+    // Отдаёт буфер вместе с элементами без копирования, вектор остаётся пустым и без буфера
+    OwnedBuffer<T> Release() {
+        typename RawMemory<T, Alloc>::ReleasedBuffer released = data_.Release();
+        Stats::template OnRelease<T>(size_, released.capacity);
+        InvalidateIterators();
+        return OwnedBuffer<T>(released.buffer, std::exchange(size_, 0), released.capacity, std::move(released.deleter));
+    }
+
+    // Уменьшает ёмкость до размера вектора. Если перенос элементов выбросит исключение,
+    // вектор останется прежним
+    void ShrinkToFit() {
+        if(size_ < data_.Capacity()) {
+            ShrinkTo(size_);
+        }
+    }
     
     size_t Size() const noexcept {
         return size_;
@@ -227,94 +1471,385 @@ public:
         return data_.Capacity();
     }
 
+    // Указатель на элементы, выровненный по ALIGNMENT, о чём известно компилятору.
+    // У вектора без буфера возвращает nullptr
+    T* AssumeAligned() noexcept {
+        return AssumeAlignedPointer<ALIGNMENT>(data_.GetAddress());
+    }
+
+    const T* AssumeAligned() const noexcept {
+        return AssumeAlignedPointer<ALIGNMENT>(data_.GetAddress());
+    }
+
     const T& operator[](size_t index) const noexcept {
         return const_cast<Vector&>(*this)[index];
     }
 
     T& operator[](size_t index) noexcept {
-        assert(index < size_);
+        if constexpr (Checks::CHECK_BOUNDS) {
+            if(index >= size_) {
+                VectorCheckFailed("Index is out of range");
+            }
+        } else {
+            assert(index < size_);
+        }
         return data_[index];
     }
+
+    // Указатель на элементы, не зависящий от политики проверок
+    T* Data() noexcept {
+        return data_.GetAddress();
+    }
+
+    const T* Data() const noexcept {
+        return data_.GetAddress();
+    }
     
     iterator begin() noexcept {
-        return data_.GetAddress();
+        return MakeIterator(data_.GetAddress());
     }
     
     iterator end() noexcept {
-        return data_ + size_;
+        return MakeIterator(data_ + size_);
     }
     
     const_iterator begin() const noexcept {
-        return data_.GetAddress();
+        return MakeIterator(data_.GetAddress());
     }
     
     const_iterator end() const noexcept {
-        return data_ + size_;
+        return MakeIterator(data_ + size_);
     }
     
     const_iterator cbegin() const noexcept {
-        return data_.GetAddress();
+        return begin();
     }
     
     const_iterator cend() const noexcept {
-        return data_ + size_;
+        return end();
     }
     
     ~Vector() {
+        Stats::template OnRelease<T>(size_, data_.Capacity());
         DestroyN(data_.GetAddress(), size_);
     }
 
 private:
-    static void Destroy(T* buf) noexcept {
-        buf->~T();
+    using vector_checks_detail::IteratorGeneration<Checks::CHECK_ITERATORS>::InvalidateIterators;
+
+    iterator MakeIterator(T* ptr) noexcept {
+        if constexpr (Checks::CHECK_ITERATORS) {
+            return iterator(this, ptr);
+        } else {
+            return ptr;
+        }
     }
-    
-    static void DestroyN(T* buf, size_t n) noexcept {
-        for(size_t i = 0; i != n; ++i) {
-            Destroy(buf);
+
+    const_iterator MakeIterator(const T* ptr) const noexcept {
+        if constexpr (Checks::CHECK_ITERATORS) {
+            return const_iterator(this, ptr);
+        } else {
+            return ptr;
         }
     }
-    
-    constexpr void Uninitialized(T* data, size_t size, T* new_data ) {
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move_n(data, size, new_data);
+
+    // Номер позиции pos. Позиция end() допустима, только если allow_end
+    size_t PositionOf(const_iterator pos, bool allow_end) const noexcept {
+        const T* ptr;
+        if constexpr (Checks::CHECK_ITERATORS) {
+            if(pos.owner_ != this) {
+                VectorCheckFailed("Iterator belongs to another vector");
+            }
+            pos.Offset();
+            ptr = pos.ptr_;
+        } else {
+            ptr = pos;
+        }
+        const size_t offset = static_cast<size_t>(ptr - data_.GetAddress());
+        if constexpr (Checks::CHECK_BOUNDS) {
+            if(offset > size_ || (offset == size_ && !allow_end)) {
+                VectorCheckFailed("Position is out of range");
+            }
+        }
+        return offset;
+    }
+
+    // Источник элементов для InsertN и AssignN: конструирует или присваивает count элементов,
+    // начиная с номера from, в память dst
+    template <typename ForwardIt>
+    struct RangeSource {
+        void Construct(T* dst, size_t from, size_t count) const {
+            if constexpr (std::is_trivially_copyable_v<T> && std::is_pointer_v<ForwardIt>
+                          && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<ForwardIt>>, T>) {
+                if(count != 0) {
+                    std::memcpy(static_cast<void*>(dst), first + from, count * sizeof(T));
+                }
+            } else {
+                std::uninitialized_copy_n(std::next(first, from), count, dst);
+            }
+        }
+
+        void Assign(T* dst, size_t from, size_t count) const {
+            if constexpr (std::is_trivially_copyable_v<T> && std::is_pointer_v<ForwardIt>
+                          && std::is_same_v<std::remove_cv_t<std::remove_pointer_t<ForwardIt>>, T>) {
+                if(count != 0) {
+                    std::memcpy(static_cast<void*>(dst), first + from, count * sizeof(T));
+                }
+            } else {
+                std::copy_n(std::next(first, from), count, dst);
+            }
+        }
+
+        ForwardIt first;
+    };
+
+    struct FillSource {
+        void Construct(T* dst, size_t /*from*/, size_t count) const {
+            std::uninitialized_fill_n(dst, count, value);
+        }
+
+        void Assign(T* dst, size_t /*from*/, size_t count) const {
+            std::fill_n(dst, count, value);
+        }
+
+        const T& value;
+    };
+
+    struct ValueInitSource {
+        void Construct(T* dst, size_t /*from*/, size_t count) const {
+            std::uninitialized_value_construct_n(dst, count);
+        }
+    };
+
+    // Элементы тривиальных типов остаются неинициализированными, но страницы их памяти
+    // всё равно затрагиваются записью, чтобы закрепить их за создающим потоком
+    struct DefaultInitSource {
+        static constexpr size_t PAGE_SIZE = 4096;
+
+        void Construct(T* dst, size_t /*from*/, size_t count) const {
+            std::uninitialized_default_construct_n(dst, count);
+            if constexpr (std::is_trivially_default_constructible_v<T>) {
+                unsigned char* bytes = reinterpret_cast<unsigned char*>(dst);
+                for(size_t offset = 0; offset < count * sizeof(T); offset += PAGE_SIZE) {
+                    bytes[offset] = 0;
+                }
+            }
+        }
+    };
+
+    // Вставляет count элементов source в позицию offset
+    template <typename Source>
+    T* InsertN(size_t offset, size_t count, const Source& source) {
+        if(count == 0) {
+            return data_ + offset;
+        }
+        if(size_ + count > data_.Capacity()) {
+            StatsProbe probe;
+            const size_t old_capacity = data_.Capacity();
+            const size_t new_capacity = Growth::NextCapacity(old_capacity, size_ + count, sizeof(T));
+            if constexpr (RawMemory<T, Alloc>::CanReallocate()) {
+                data_.Reallocate(new_capacity);
+                InvalidateIterators();
+                probe.Commit(old_capacity, new_capacity, size_);
+            } else {
+                RawMemory<T, Alloc> new_data(new_capacity, data_.GetAllocator());
+                source.Construct(new_data + offset, 0, count);
+                try {
+                    UninitializedTransferN(data_.GetAddress(), offset, new_data.GetAddress());
+                } catch (...) {
+                    DestroyN(new_data + offset, count);
+                    throw;
+                }
+                try {
+                    UninitializedTransferN(data_ + offset, size_ - offset, new_data + offset + count);
+                } catch (...) {
+                    DestroyN(new_data.GetAddress(), offset + count);
+                    throw;
+                }
+                DestroyAndSwap(new_data);
+                probe.Commit(old_capacity, new_capacity, size_);
+                size_ += count;
+                return data_ + offset;
+            }
+        }
+        T* insert_pos = data_ + offset;
+        const size_t tail = size_ - offset;
+        if constexpr (is_trivially_relocatable_v<T>) {
+            std::memmove(static_cast<void*>(insert_pos + count), insert_pos, tail * sizeof(T));
+            try {
+                source.Construct(insert_pos, 0, count);
+            } catch (...) {
+                std::memmove(static_cast<void*>(insert_pos), insert_pos + count, tail * sizeof(T));
+                throw;
+            }
+            size_ += count;
+        } else if(tail > count) {
+            T* old_end = data_ + size_;
+            std::uninitialized_move_n(old_end - count, count, old_end);
+            size_ += count;
+            std::move_backward(insert_pos, old_end - count, old_end);
+            source.Assign(insert_pos, 0, count);
+        } else {
+            T* old_end = data_ + size_;
+            source.Construct(old_end, tail, count - tail);
+            try {
+                std::uninitialized_move_n(insert_pos, tail, insert_pos + count);
+            } catch (...) {
+                DestroyN(old_end, count - tail);
+                throw;
+            }
+            size_ += count;
+            source.Assign(insert_pos, 0, tail);
+        }
+        return insert_pos;
+    }
+
+    // Заменяет содержимое вектора count элементами source
+    template <typename Source>
+    void AssignN(size_t count, const Source& source) {
+        if(count > data_.Capacity()) {
+            RawMemory<T, Alloc> new_data(count, data_.GetAllocator());
+            source.Construct(new_data.GetAddress(), 0, count);
+            Stats::template OnRelease<T>(size_, data_.Capacity());
+            DestroyN(data_.GetAddress(), size_);
+            data_.Swap(new_data);
+            InvalidateIterators();
+        } else if(count <= size_) {
+            source.Assign(data_.GetAddress(), 0, count);
+            DestroyN(data_ + count, size_ - count);
+        } else {
+            source.Assign(data_.GetAddress(), 0, size_);
+            source.Construct(data_ + size_, size_, count - size_);
+        }
+        size_ = count;
+    }
+
+    void ShrinkTo(size_t new_capacity) {
+        assert(size_ <= new_capacity && new_capacity < data_.Capacity());
+        StatsProbe probe;
+        const size_t old_capacity = data_.Capacity();
+        if constexpr (RawMemory<T, Alloc>::CanReallocate()) {
+            data_.Reallocate(new_capacity);
+            InvalidateIterators();
         } else {
-            std::uninitialized_copy_n(data, size, new_data);
+            RawMemory<T, Alloc> new_data(new_capacity, data_.GetAllocator());
+            UninitializedTransferN(data_.GetAddress(), size_, new_data.GetAddress());
+            DestroyAndSwap(new_data);
+        }
+        probe.Commit(old_capacity, new_capacity, size_);
+    }
+
+    // Уменьшает буфер, если этого требует политика роста. Уменьшение необязательно,
+    // поэтому при нехватке памяти или ошибке переноса буфер просто остаётся прежним
+    void AutoShrink() noexcept {
+        if constexpr (HasShrinkCapacity<Growth>::value) {
+            const size_t new_capacity = Growth::ShrinkCapacity(size_, data_.Capacity(), sizeof(T));
+            if(new_capacity < data_.Capacity()) {
+                try {
+                    ShrinkTo(std::max(new_capacity, size_));
+                } catch (...) {
+                }
+            }
         }
     }
+
+    // Ёмкость буфера, в который переезжают элементы, когда в текущем не осталось места
+    size_t NextCapacity() const noexcept {
+        return Growth::NextCapacity(data_.Capacity(), size_ + 1, sizeof(T));
+    }
     
-    void DestroyAndSwap(RawMemory<T>& new_data) {
-        std::destroy_n(data_.GetAddress(), size_);
+    void DestroyAndSwap(RawMemory<T, Alloc>& new_data) {
+        DestroyTransferredN(data_.GetAddress(), size_);
         data_.Swap(new_data);
+        InvalidateIterators();
+    }
+
+    template <typename... Args>
+    T* EmplaceAt(size_t offset, Args&&... args) {
+        if(size_ == data_.Capacity()) {
+            return ReallocationEmplace(offset, std::forward<Args>(args)...);
+        }
+        return NoReallocationEmplace(offset, std::forward<Args>(args)...);
     }
     
     template <typename... Args>
-    iterator ReallocationEmplace(const_iterator pos, Args&&... args) {
-        size_t new_pos = pos - begin();
-        RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
+    T* ReallocationEmplace(size_t new_pos, Args&&... args) {
+        if constexpr (RawMemory<T, Alloc>::CanReallocate()) {
+            return InPlaceReallocationEmplace(new_pos, std::forward<Args>(args)...);
+        }
+        StatsProbe probe;
+        const size_t old_capacity = data_.Capacity();
+        RawMemory<T, Alloc> new_data(NextCapacity(), data_.GetAllocator());
         T* elem = new (new_data + new_pos) T(std::forward<Args>(args)...);
-        Uninitialized(data_.GetAddress(), new_pos, new_data.GetAddress());
-        Uninitialized(data_ + new_pos, size_ - new_pos, new_data + new_pos + 1);
+        try {
+            UninitializedTransferN(data_.GetAddress(), new_pos, new_data.GetAddress());
+        } catch (...) {
+            elem->~T();
+            throw;
+        }
+        try {
+            UninitializedTransferN(data_ + new_pos, size_ - new_pos, new_data + new_pos + 1);
+        } catch (...) {
+            DestroyN(new_data.GetAddress(), new_pos + 1);
+            throw;
+        }
         DestroyAndSwap(new_data);
+        probe.Commit(old_capacity, data_.Capacity(), size_);
         ++size_;
         return elem;
     }
     
+    // Расширяет буфер на месте и вставляет элемент. Аргументы могут ссылаться на элементы
+    // вектора, поэтому новый элемент создаётся во временной памяти до вызова Reallocate
+    // и затем переносится на своё место побайтово
     template <typename... Args>
-    iterator NoReallocationEmplace(const_iterator pos, Args&&... args) {
-        size_t new_pos = pos - begin();
-        if(pos == end()) {
-            new(data_ + size_) T(std::forward<Args>(args)...);
-        } else {
-            T elem(std::forward<Args>(args)...);
-            new (data_ + size_) T(std::move(*(end() - 1)));
-            std::move_backward(data_ + new_pos, end() - 1, end());
-            *(data_ + new_pos) = std::move(elem);
+    T* InPlaceReallocationEmplace(size_t new_pos, Args&&... args) {
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* elem = new (storage) T(std::forward<Args>(args)...);
+        StatsProbe probe;
+        const size_t old_capacity = data_.Capacity();
+        try {
+            data_.Reallocate(NextCapacity());
+        } catch (...) {
+            elem->~T();
+            throw;
         }
+        InvalidateIterators();
+        probe.Commit(old_capacity, data_.Capacity(), size_);
+        T* elem_pos = data_ + new_pos;
+        std::memmove(static_cast<void*>(elem_pos + 1), elem_pos, (size_ - new_pos) * sizeof(T));
+        std::memcpy(static_cast<void*>(elem_pos), storage, sizeof(T));
+        ++size_;
+        return elem_pos;
+    }
+
+    template <typename... Args>
+    T* NoReallocationEmplace(size_t new_pos, Args&&... args) {
+        T* elem = new_pos == size_ ? new (data_ + size_) T(std::forward<Args>(args)...)
+                                   : ShiftAndEmplace(data_.GetAddress(), size_, new_pos, std::forward<Args>(args)...);
         ++size_;
-        return const_cast<iterator>(pos);
+        return elem;
     }
 
-    RawMemory<T> data_;
+    RawMemory<T, Alloc> data_;
     size_t size_ = 0;
-};
\ No newline at end of file
+};
+
+// Удаляет из вектора элементы, удовлетворяющие предикату, за один проход
+// и возвращает количество удалённых элементов
+template <typename T, typename Alloc, typename Growth, typename Stats, typename Checks, typename Predicate>
+size_t EraseIf(Vector<T, Alloc, Growth, Stats, Checks>& vector, Predicate pred) {
+    auto first = std::find_if(vector.begin(), vector.end(), pred);
+    if(first == vector.end()) {
+        return 0;
+    }
+    for(auto it = std::next(first); it != vector.end(); ++it) {
+        if(!pred(*it)) {
+            MoveOrCopyAssign(it, std::next(it), first);
+            ++first;
+        }
+    }
+    const size_t erased = vector.end() - first;
+    vector.Erase(first, vector.end());
+    return erased;
+}
@@ -0,0 +1,1005 @@
+#pragma once
+#include "vector.h"
+#include "span.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VECTOR_ALGORITHMS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON) && (defined(__GNUC__) || defined(__clang__))
+#define VECTOR_ALGORITHMS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Поиск, подсчёт, минимум и максимум, сумма, заполнение и сравнение непрерывных диапазонов
+// векторными инструкциями. Для элементов int32_t, float и double выбирается ядро AVX-512,
+// AVX2 или NEON, поддерживаемое процессором, для остальных типов и на других процессорах
+// выполняется обычный цикл.
+// Результаты совпадают со стандартными алгоритмами с оператором ==, кроме двух случаев:
+// сумма float и double складывается в другом порядке и может отличаться в младших битах,
+// а MinMax диапазона, содержащего NaN, не определён
+enum class SimdLevel {
+    SCALAR,
+    AVX2,
+    AVX512,
+    NEON,
+};
+
+// Сумма целых накапливается в 64 битах и не переполняется для векторов int32_t
+template <typename T>
+using SumResult = std::conditional_t<std::is_integral_v<T>, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>, T>;
+
+inline bool IsSimdLevelSupported(SimdLevel level) noexcept {
+    switch(level) {
+        case SimdLevel::SCALAR:
+            return true;
+#if defined(VECTOR_ALGORITHMS_X86)
+        case SimdLevel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case SimdLevel::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#elif defined(VECTOR_ALGORITHMS_NEON)
+        case SimdLevel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+// Наиболее быстрый набор инструкций, поддерживаемый процессором
+inline SimdLevel DetectSimdLevel() noexcept {
+    for(SimdLevel level : {SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::NEON}) {
+        if(IsSimdLevelSupported(level)) {
+            return level;
+        }
+    }
+    return SimdLevel::SCALAR;
+}
+
+namespace vector_algorithms_detail {
+
+inline std::atomic<SimdLevel>& ActiveLevel() noexcept {
+    static std::atomic<SimdLevel> level{DetectSimdLevel()};
+    return level;
+}
+
+// Тип значения берётся из контейнера, так что Find(doubles, 1) не вызывает конфликта выведения
+template <typename T>
+struct TypeIdentity {
+    using type = T;
+};
+
+template <typename T>
+using NonDeduced = typename TypeIdentity<T>::type;
+
+template <typename T>
+inline constexpr bool IS_SIMD_ELEMENT =
+    std::is_same_v<T, int32_t> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// Стандартные алгоритмы для процессоров без векторных ядер и остальных типов элементов
+template <typename T>
+struct ScalarKernels {
+    static size_t Find(const T* data, size_t size, const T& value) {
+        return static_cast<size_t>(std::find(data, data + size, value) - data);
+    }
+
+    static size_t Count(const T* data, size_t size, const T& value) {
+        return static_cast<size_t>(std::count(data, data + size, value));
+    }
+
+    static void MinMax(const T* data, size_t size, T& min, T& max) {
+        const auto [min_it, max_it] = std::minmax_element(data, data + size);
+        min = *min_it;
+        max = *max_it;
+    }
+
+    static SumResult<T> Sum(const T* data, size_t size) {
+        return std::accumulate(data, data + size, SumResult<T>{});
+    }
+
+    static void Fill(T* data, size_t size, const T& value) {
+        std::fill_n(data, size, value);
+    }
+
+    static bool Equal(const T* lhs, const T* rhs, size_t size) {
+        return std::equal(lhs, lhs + size, rhs);
+    }
+};
+
+// Простые циклы для остатков внутри векторных ядер. Они всегда встраиваются и собираются
+// с набором инструкций ядра: обычная функция с кодом SSE, вызванная после работы
+// с регистрами AVX без vzeroupper, выполняется в десятки раз медленнее
+#if defined(__GNUC__) || defined(__clang__)
+#define VECTOR_ALGORITHMS_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER)
+#define VECTOR_ALGORITHMS_INLINE __forceinline
+#else
+#define VECTOR_ALGORITHMS_INLINE inline
+#endif
+
+template <typename T>
+struct TailLoops {
+    VECTOR_ALGORITHMS_INLINE static size_t Find(const T* data, size_t first, size_t size, T value) {
+        for(; first < size; ++first) {
+            if(data[first] == value) {
+                return first;
+            }
+        }
+        return size;
+    }
+
+    VECTOR_ALGORITHMS_INLINE static size_t Count(const T* data, size_t first, size_t size, T value) {
+        size_t count = 0;
+        for(; first < size; ++first) {
+            count += data[first] == value;
+        }
+        return count;
+    }
+
+    VECTOR_ALGORITHMS_INLINE static T Min(const T* data, size_t size) {
+        T min = data[0];
+        for(size_t i = 1; i < size; ++i) {
+            min = data[i] < min ? data[i] : min;
+        }
+        return min;
+    }
+
+    VECTOR_ALGORITHMS_INLINE static T Max(const T* data, size_t size) {
+        T max = data[0];
+        for(size_t i = 1; i < size; ++i) {
+            max = max < data[i] ? data[i] : max;
+        }
+        return max;
+    }
+
+    template <typename Element>
+    VECTOR_ALGORITHMS_INLINE static SumResult<T> Sum(const Element* data, size_t first, size_t size) {
+        SumResult<T> sum{};
+        for(; first < size; ++first) {
+            sum += data[first];
+        }
+        return sum;
+    }
+
+    VECTOR_ALGORITHMS_INLINE static void Fill(T* data, size_t first, size_t size, T value) {
+        for(; first < size; ++first) {
+            data[first] = value;
+        }
+    }
+
+    VECTOR_ALGORITHMS_INLINE static bool Equal(const T* lhs, const T* rhs, size_t first, size_t size) {
+        for(; first < size; ++first) {
+            if(!(lhs[first] == rhs[first])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+#if defined(VECTOR_ALGORITHMS_X86)
+#define VECTOR_ALGORITHMS_AVX2 __attribute__((target("avx2")))
+#define VECTOR_ALGORITHMS_AVX512 __attribute__((target("avx512f")))
+// Ядра с битовыми масками сравнения на x86 собираются для AVX2
+#define VECTOR_ALGORITHMS_MASK_TARGET VECTOR_ALGORITHMS_AVX2
+
+// Операции над регистром AVX2. EqualMask возвращает по биту на элемент
+template <typename T>
+struct Avx2Lanes;
+
+template <>
+struct Avx2Lanes<int32_t> {
+    using Reg = __m256i;
+    using SumReg = __m256i;
+    using SumElement = int64_t;
+    static constexpr size_t LANES = 8;
+    static constexpr size_t SUM_LANES = 4;
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Load(const int32_t* data) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static void Store(int32_t* data, Reg reg) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Broadcast(int32_t value) {
+        return _mm256_set1_epi32(value);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static unsigned EqualMask(Reg lhs, Reg rhs) {
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lhs, rhs))));
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Min(Reg lhs, Reg rhs) {
+        return _mm256_min_epi32(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Max(Reg lhs, Reg rhs) {
+        return _mm256_max_epi32(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static SumReg SumZero() {
+        return _mm256_setzero_si256();
+    }
+
+    // Расширяет элементы до 64 бит перед сложением
+    VECTOR_ALGORITHMS_AVX2 static SumReg SumAdd(SumReg sum, Reg reg) {
+        sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(reg)));
+        return _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(reg, 1)));
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static void SumStore(int64_t* data, SumReg sum) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), sum);
+    }
+};
+
+template <>
+struct Avx2Lanes<float> {
+    using Reg = __m256;
+    using SumReg = __m256;
+    using SumElement = float;
+    static constexpr size_t LANES = 8;
+    static constexpr size_t SUM_LANES = 8;
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Load(const float* data) {
+        return _mm256_loadu_ps(data);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static void Store(float* data, Reg reg) {
+        _mm256_storeu_ps(data, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Broadcast(float value) {
+        return _mm256_set1_ps(value);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static unsigned EqualMask(Reg lhs, Reg rhs) {
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(lhs, rhs, _CMP_EQ_OQ)));
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Min(Reg lhs, Reg rhs) {
+        return _mm256_min_ps(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Max(Reg lhs, Reg rhs) {
+        return _mm256_max_ps(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static SumReg SumZero() {
+        return _mm256_setzero_ps();
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static SumReg SumAdd(SumReg sum, Reg reg) {
+        return _mm256_add_ps(sum, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static void SumStore(float* data, SumReg sum) {
+        _mm256_storeu_ps(data, sum);
+    }
+};
+
+template <>
+struct Avx2Lanes<double> {
+    using Reg = __m256d;
+    using SumReg = __m256d;
+    using SumElement = double;
+    static constexpr size_t LANES = 4;
+    static constexpr size_t SUM_LANES = 4;
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Load(const double* data) {
+        return _mm256_loadu_pd(data);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static void Store(double* data, Reg reg) {
+        _mm256_storeu_pd(data, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Broadcast(double value) {
+        return _mm256_set1_pd(value);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static unsigned EqualMask(Reg lhs, Reg rhs) {
+        return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, _CMP_EQ_OQ)));
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Min(Reg lhs, Reg rhs) {
+        return _mm256_min_pd(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static Reg Max(Reg lhs, Reg rhs) {
+        return _mm256_max_pd(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static SumReg SumZero() {
+        return _mm256_setzero_pd();
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static SumReg SumAdd(SumReg sum, Reg reg) {
+        return _mm256_add_pd(sum, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX2 static void SumStore(double* data, SumReg sum) {
+        _mm256_storeu_pd(data, sum);
+    }
+};
+
+// Заголовки AVX-512 в GCC 12 заполняют неопределённые части регистров самоинициализацией,
+// на которую выдаётся ложное предупреждение в каждом месте встраивания
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Операции над регистром AVX-512. Неполный последний блок читается и пишется по маске
+template <typename T>
+struct Avx512Lanes;
+
+template <>
+struct Avx512Lanes<int32_t> {
+    using Reg = __m512i;
+    using SumReg = __m512i;
+    using SumElement = int64_t;
+    using Mask = __mmask16;
+    static constexpr size_t LANES = 16;
+    static constexpr size_t SUM_LANES = 8;
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Load(const int32_t* data) {
+        return _mm512_loadu_si512(data);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg MaskedLoad(Mask mask, const int32_t* data) {
+        return _mm512_maskz_loadu_epi32(mask, data);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void Store(int32_t* data, Reg reg) {
+        _mm512_storeu_si512(data, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void MaskedStore(Mask mask, int32_t* data, Reg reg) {
+        _mm512_mask_storeu_epi32(data, mask, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Broadcast(int32_t value) {
+        return _mm512_set1_epi32(value);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Mask EqualMask(Reg lhs, Reg rhs) {
+        return _mm512_cmpeq_epi32_mask(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Min(Reg lhs, Reg rhs) {
+        return _mm512_min_epi32(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Max(Reg lhs, Reg rhs) {
+        return _mm512_max_epi32(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static SumReg SumZero() {
+        return _mm512_setzero_si512();
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static SumReg SumAdd(SumReg sum, Reg reg) {
+        sum = _mm512_add_epi64(sum, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(reg)));
+        return _mm512_add_epi64(sum, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(reg, 1)));
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void SumStore(int64_t* data, SumReg sum) {
+        _mm512_storeu_si512(data, sum);
+    }
+};
+
+template <>
+struct Avx512Lanes<float> {
+    using Reg = __m512;
+    using SumReg = __m512;
+    using SumElement = float;
+    using Mask = __mmask16;
+    static constexpr size_t LANES = 16;
+    static constexpr size_t SUM_LANES = 16;
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Load(const float* data) {
+        return _mm512_loadu_ps(data);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg MaskedLoad(Mask mask, const float* data) {
+        return _mm512_maskz_loadu_ps(mask, data);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void Store(float* data, Reg reg) {
+        _mm512_storeu_ps(data, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void MaskedStore(Mask mask, float* data, Reg reg) {
+        _mm512_mask_storeu_ps(data, mask, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Broadcast(float value) {
+        return _mm512_set1_ps(value);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Mask EqualMask(Reg lhs, Reg rhs) {
+        return _mm512_cmp_ps_mask(lhs, rhs, _CMP_EQ_OQ);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Min(Reg lhs, Reg rhs) {
+        return _mm512_min_ps(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Max(Reg lhs, Reg rhs) {
+        return _mm512_max_ps(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static SumReg SumZero() {
+        return _mm512_setzero_ps();
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static SumReg SumAdd(SumReg sum, Reg reg) {
+        return _mm512_add_ps(sum, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void SumStore(float* data, SumReg sum) {
+        _mm512_storeu_ps(data, sum);
+    }
+};
+
+template <>
+struct Avx512Lanes<double> {
+    using Reg = __m512d;
+    using SumReg = __m512d;
+    using SumElement = double;
+    using Mask = __mmask8;
+    static constexpr size_t LANES = 8;
+    static constexpr size_t SUM_LANES = 8;
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Load(const double* data) {
+        return _mm512_loadu_pd(data);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg MaskedLoad(Mask mask, const double* data) {
+        return _mm512_maskz_loadu_pd(mask, data);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void Store(double* data, Reg reg) {
+        _mm512_storeu_pd(data, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void MaskedStore(Mask mask, double* data, Reg reg) {
+        _mm512_mask_storeu_pd(data, mask, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Broadcast(double value) {
+        return _mm512_set1_pd(value);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Mask EqualMask(Reg lhs, Reg rhs) {
+        return _mm512_cmp_pd_mask(lhs, rhs, _CMP_EQ_OQ);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Min(Reg lhs, Reg rhs) {
+        return _mm512_min_pd(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static Reg Max(Reg lhs, Reg rhs) {
+        return _mm512_max_pd(lhs, rhs);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static SumReg SumZero() {
+        return _mm512_setzero_pd();
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static SumReg SumAdd(SumReg sum, Reg reg) {
+        return _mm512_add_pd(sum, reg);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void SumStore(double* data, SumReg sum) {
+        _mm512_storeu_pd(data, sum);
+    }
+};
+
+// Ядра AVX-512: остаток, не заполняющий регистр, обрабатывается той же операцией по маске
+template <typename T>
+struct Avx512Kernels {
+    using L = Avx512Lanes<T>;
+    using Reg = typename L::Reg;
+    using Mask = typename L::Mask;
+    static constexpr size_t LANES = L::LANES;
+
+    static Mask TailMask(size_t count) noexcept {
+        return static_cast<Mask>((1u << count) - 1);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static size_t Find(const T* data, size_t size, T value) {
+        const Reg needle = L::Broadcast(value);
+        size_t i = 0;
+        for(; i + LANES <= size; i += LANES) {
+            if(const unsigned mask = L::EqualMask(L::Load(data + i), needle)) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        if(i < size) {
+            const Mask tail = TailMask(size - i);
+            if(const unsigned mask = L::EqualMask(L::MaskedLoad(tail, data + i), needle) & tail) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        return size;
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static size_t Count(const T* data, size_t size, T value) {
+        const Reg needle = L::Broadcast(value);
+        size_t count = 0;
+        size_t i = 0;
+        for(; i + LANES <= size; i += LANES) {
+            count += __builtin_popcount(L::EqualMask(L::Load(data + i), needle));
+        }
+        if(i < size) {
+            const Mask tail = TailMask(size - i);
+            count += __builtin_popcount(L::EqualMask(L::MaskedLoad(tail, data + i), needle) & tail);
+        }
+        return count;
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void MinMax(const T* data, size_t size, T& min, T& max) {
+        if(size < LANES) {
+            min = TailLoops<T>::Min(data, size);
+            max = TailLoops<T>::Max(data, size);
+            return;
+        }
+        Reg min_reg = L::Load(data);
+        Reg max_reg = min_reg;
+        for(size_t i = LANES; i < size; i += LANES) {
+            // Последний блок сдвигается назад и повторно читает уже учтённые элементы
+            const Reg reg = L::Load(data + std::min(i, size - LANES));
+            min_reg = L::Min(min_reg, reg);
+            max_reg = L::Max(max_reg, reg);
+        }
+        T lanes[LANES];
+        L::Store(lanes, min_reg);
+        min = TailLoops<T>::Min(lanes, LANES);
+        L::Store(lanes, max_reg);
+        max = TailLoops<T>::Max(lanes, LANES);
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static SumResult<T> Sum(const T* data, size_t size) {
+        // Независимые накопители скрывают задержку сложения
+        typename L::SumReg sums[4] = {L::SumZero(), L::SumZero(), L::SumZero(), L::SumZero()};
+        size_t i = 0;
+        for(; i + 4 * LANES <= size; i += 4 * LANES) {
+            for(size_t k = 0; k < 4; ++k) {
+                sums[k] = L::SumAdd(sums[k], L::Load(data + i + k * LANES));
+            }
+        }
+        for(; i + LANES <= size; i += LANES) {
+            sums[0] = L::SumAdd(sums[0], L::Load(data + i));
+        }
+        if(i < size) {
+            sums[1] = L::SumAdd(sums[1], L::MaskedLoad(TailMask(size - i), data + i));
+        }
+        SumResult<T> total{};
+        typename L::SumElement parts[L::SUM_LANES];
+        for(const auto& sum : sums) {
+            L::SumStore(parts, sum);
+            total += TailLoops<T>::Sum(parts, 0, L::SUM_LANES);
+        }
+        return total;
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static void Fill(T* data, size_t size, T value) {
+        const Reg reg = L::Broadcast(value);
+        size_t i = 0;
+        for(; i + LANES <= size; i += LANES) {
+            L::Store(data + i, reg);
+        }
+        if(i < size) {
+            L::MaskedStore(TailMask(size - i), data + i, reg);
+        }
+    }
+
+    VECTOR_ALGORITHMS_AVX512 static bool Equal(const T* lhs, const T* rhs, size_t size) {
+        const Mask all = static_cast<Mask>(~Mask{0});
+        size_t i = 0;
+        for(; i + LANES <= size; i += LANES) {
+            if(L::EqualMask(L::Load(lhs + i), L::Load(rhs + i)) != all) {
+                return false;
+            }
+        }
+        if(i < size) {
+            const Mask tail = TailMask(size - i);
+            return (L::EqualMask(L::MaskedLoad(tail, lhs + i), L::MaskedLoad(tail, rhs + i)) & tail) == tail;
+        }
+        return true;
+    }
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+template <typename T>
+using MaskLanes = Avx2Lanes<T>;
+#elif defined(VECTOR_ALGORITHMS_NEON)
+// NEON входит в базовый набор AArch64 и не требует отдельной цели сборки
+#define VECTOR_ALGORITHMS_MASK_TARGET
+
+template <typename T>
+struct NeonLanes;
+
+template <>
+struct NeonLanes<int32_t> {
+    using Reg = int32x4_t;
+    using SumReg = int64x2_t;
+    using SumElement = int64_t;
+    static constexpr size_t LANES = 4;
+    static constexpr size_t SUM_LANES = 2;
+
+    static Reg Load(const int32_t* data) {
+        return vld1q_s32(data);
+    }
+
+    static void Store(int32_t* data, Reg reg) {
+        vst1q_s32(data, reg);
+    }
+
+    static Reg Broadcast(int32_t value) {
+        return vdupq_n_s32(value);
+    }
+
+    // В NEON нет переноса старших битов в маску, поэтому каждому элементу назначается свой бит
+    static unsigned EqualMask(Reg lhs, Reg rhs) {
+        static constexpr uint32_t BITS[4] = {1, 2, 4, 8};
+        return vaddvq_u32(vandq_u32(vceqq_s32(lhs, rhs), vld1q_u32(BITS)));
+    }
+
+    static Reg Min(Reg lhs, Reg rhs) {
+        return vminq_s32(lhs, rhs);
+    }
+
+    static Reg Max(Reg lhs, Reg rhs) {
+        return vmaxq_s32(lhs, rhs);
+    }
+
+    static SumReg SumZero() {
+        return vdupq_n_s64(0);
+    }
+
+    // Складывает соседние элементы попарно в 64-битные суммы
+    static SumReg SumAdd(SumReg sum, Reg reg) {
+        return vpadalq_s32(sum, reg);
+    }
+
+    static void SumStore(int64_t* data, SumReg sum) {
+        vst1q_s64(data, sum);
+    }
+};
+
+template <>
+struct NeonLanes<float> {
+    using Reg = float32x4_t;
+    using SumReg = float32x4_t;
+    using SumElement = float;
+    static constexpr size_t LANES = 4;
+    static constexpr size_t SUM_LANES = 4;
+
+    static Reg Load(const float* data) {
+        return vld1q_f32(data);
+    }
+
+    static void Store(float* data, Reg reg) {
+        vst1q_f32(data, reg);
+    }
+
+    static Reg Broadcast(float value) {
+        return vdupq_n_f32(value);
+    }
+
+    static unsigned EqualMask(Reg lhs, Reg rhs) {
+        static constexpr uint32_t BITS[4] = {1, 2, 4, 8};
+        return vaddvq_u32(vandq_u32(vceqq_f32(lhs, rhs), vld1q_u32(BITS)));
+    }
+
+    static Reg Min(Reg lhs, Reg rhs) {
+        return vminq_f32(lhs, rhs);
+    }
+
+    static Reg Max(Reg lhs, Reg rhs) {
+        return vmaxq_f32(lhs, rhs);
+    }
+
+    static SumReg SumZero() {
+        return vdupq_n_f32(0);
+    }
+
+    static SumReg SumAdd(SumReg sum, Reg reg) {
+        return vaddq_f32(sum, reg);
+    }
+
+    static void SumStore(float* data, SumReg sum) {
+        vst1q_f32(data, sum);
+    }
+};
+
+template <>
+struct NeonLanes<double> {
+    using Reg = float64x2_t;
+    using SumReg = float64x2_t;
+    using SumElement = double;
+    static constexpr size_t LANES = 2;
+    static constexpr size_t SUM_LANES = 2;
+
+    static Reg Load(const double* data) {
+        return vld1q_f64(data);
+    }
+
+    static void Store(double* data, Reg reg) {
+        vst1q_f64(data, reg);
+    }
+
+    static Reg Broadcast(double value) {
+        return vdupq_n_f64(value);
+    }
+
+    static unsigned EqualMask(Reg lhs, Reg rhs) {
+        static constexpr uint64_t BITS[2] = {1, 2};
+        return static_cast<unsigned>(vaddvq_u64(vandq_u64(vceqq_f64(lhs, rhs), vld1q_u64(BITS))));
+    }
+
+    static Reg Min(Reg lhs, Reg rhs) {
+        return vminq_f64(lhs, rhs);
+    }
+
+    static Reg Max(Reg lhs, Reg rhs) {
+        return vmaxq_f64(lhs, rhs);
+    }
+
+    static SumReg SumZero() {
+        return vdupq_n_f64(0);
+    }
+
+    static SumReg SumAdd(SumReg sum, Reg reg) {
+        return vaddq_f64(sum, reg);
+    }
+
+    static void SumStore(double* data, SumReg sum) {
+        vst1q_f64(data, sum);
+    }
+};
+
+template <typename T>
+using MaskLanes = NeonLanes<T>;
+#endif
+
+#if defined(VECTOR_ALGORITHMS_MASK_TARGET)
+// Ядра AVX2 и NEON: по биту маски на элемент, остаток обрабатывается обычным циклом
+template <typename T>
+struct MaskKernels {
+    using L = MaskLanes<T>;
+    using Reg = typename L::Reg;
+    static constexpr size_t LANES = L::LANES;
+
+    VECTOR_ALGORITHMS_MASK_TARGET static size_t Find(const T* data, size_t size, T value) {
+        const Reg needle = L::Broadcast(value);
+        size_t i = 0;
+        for(; i + LANES <= size; i += LANES) {
+            if(const unsigned mask = L::EqualMask(L::Load(data + i), needle)) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        return TailLoops<T>::Find(data, i, size, value);
+    }
+
+    VECTOR_ALGORITHMS_MASK_TARGET static size_t Count(const T* data, size_t size, T value) {
+        const Reg needle = L::Broadcast(value);
+        size_t count = 0;
+        size_t i = 0;
+        for(; i + LANES <= size; i += LANES) {
+            count += __builtin_popcount(L::EqualMask(L::Load(data + i), needle));
+        }
+        return count + TailLoops<T>::Count(data, i, size, value);
+    }
+
+    VECTOR_ALGORITHMS_MASK_TARGET static void MinMax(const T* data, size_t size, T& min, T& max) {
+        if(size < LANES) {
+            min = TailLoops<T>::Min(data, size);
+            max = TailLoops<T>::Max(data, size);
+            return;
+        }
+        Reg min_reg = L::Load(data);
+        Reg max_reg = min_reg;
+        for(size_t i = LANES; i < size; i += LANES) {
+            // Последний блок сдвигается назад и повторно читает уже учтённые элементы
+            const Reg reg = L::Load(data + std::min(i, size - LANES));
+            min_reg = L::Min(min_reg, reg);
+            max_reg = L::Max(max_reg, reg);
+        }
+        T lanes[LANES];
+        L::Store(lanes, min_reg);
+        min = TailLoops<T>::Min(lanes, LANES);
+        L::Store(lanes, max_reg);
+        max = TailLoops<T>::Max(lanes, LANES);
+    }
+
+    VECTOR_ALGORITHMS_MASK_TARGET static SumResult<T> Sum(const T* data, size_t size) {
+        // Независимые накопители скрывают задержку сложения
+        typename L::SumReg sums[4] = {L::SumZero(), L::SumZero(), L::SumZero(), L::SumZero()};
+        size_t i = 0;
+        for(; i + 4 * LANES <= size; i += 4 * LANES) {
+            for(size_t k = 0; k < 4; ++k) {
+                sums[k] = L::SumAdd(sums[k], L::Load(data + i + k * LANES));
+            }
+        }
+        for(; i + LANES <= size; i += LANES) {
+            sums[0] = L::SumAdd(sums[0], L::Load(data + i));
+        }
+        SumResult<T> total{};
+        typename L::SumElement parts[L::SUM_LANES];
+        for(const auto& sum : sums) {
+            L::SumStore(parts, sum);
+            total += TailLoops<T>::Sum(parts, 0, L::SUM_LANES);
+        }
+        return total + TailLoops<T>::Sum(data, i, size);
+    }
+
+    VECTOR_ALGORITHMS_MASK_TARGET static void Fill(T* data, size_t size, T value) {
+        if(size < LANES) {
+            TailLoops<T>::Fill(data, 0, size, value);
+            return;
+        }
+        const Reg reg = L::Broadcast(value);
+        for(size_t i = 0; i < size; i += LANES) {
+            L::Store(data + std::min(i, size - LANES), reg);
+        }
+    }
+
+    VECTOR_ALGORITHMS_MASK_TARGET static bool Equal(const T* lhs, const T* rhs, size_t size) {
+        constexpr unsigned ALL = (1u << LANES) - 1;
+        size_t i = 0;
+        for(; i + LANES <= size; i += LANES) {
+            if(L::EqualMask(L::Load(lhs + i), L::Load(rhs + i)) != ALL) {
+                return false;
+            }
+        }
+        return TailLoops<T>::Equal(lhs, rhs, i, size);
+    }
+};
+#endif
+
+// Вызывает run с набором ядер, выбранным для T и текущего уровня SimdLevel
+template <typename T, typename Run>
+decltype(auto) Dispatch(Run&& run) {
+    if constexpr (IS_SIMD_ELEMENT<T>) {
+        switch(ActiveLevel().load(std::memory_order_relaxed)) {
+#if defined(VECTOR_ALGORITHMS_X86)
+            case SimdLevel::AVX512:
+                return run(Avx512Kernels<T>{});
+            case SimdLevel::AVX2:
+                return run(MaskKernels<T>{});
+#elif defined(VECTOR_ALGORITHMS_NEON)
+            case SimdLevel::NEON:
+                return run(MaskKernels<T>{});
+#endif
+            default:
+                break;
+        }
+    }
+    return run(ScalarKernels<T>{});
+}
+
+}  // namespace vector_algorithms_detail
+
+inline SimdLevel GetSimdLevel() noexcept {
+    return vector_algorithms_detail::ActiveLevel().load(std::memory_order_relaxed);
+}
+
+// Переключает ядра, например, чтобы сравнить их скорость. Возвращает false и ничего
+// не меняет, если процессор не поддерживает level
+inline bool SetSimdLevel(SimdLevel level) noexcept {
+    if(!IsSimdLevelSupported(level)) {
+        return false;
+    }
+    vector_algorithms_detail::ActiveLevel().store(level, std::memory_order_relaxed);
+    return true;
+}
+
+// Первый элемент, равный value, или values.end()
+template <typename T>
+T* Find(Span<T> values, const std::remove_const_t<T>& value) {
+    using Element = std::remove_const_t<T>;
+    return values.Data() + vector_algorithms_detail::Dispatch<Element>([&](auto kernels) {
+        return decltype(kernels)::Find(values.Data(), values.Size(), value);
+    });
+}
+
+template <typename T>
+size_t Count(Span<T> values, const std::remove_const_t<T>& value) {
+    using Element = std::remove_const_t<T>;
+    return vector_algorithms_detail::Dispatch<Element>([&](auto kernels) {
+        return decltype(kernels)::Count(values.Data(), values.Size(), value);
+    });
+}
+
+// Наименьший и наибольший элементы непустого диапазона
+template <typename T>
+std::pair<std::remove_const_t<T>, std::remove_const_t<T>> MinMax(Span<T> values) {
+    using Element = std::remove_const_t<T>;
+    assert(!values.Empty());
+    std::pair<Element, Element> result;
+    vector_algorithms_detail::Dispatch<Element>([&](auto kernels) {
+        decltype(kernels)::MinMax(values.Data(), values.Size(), result.first, result.second);
+    });
+    return result;
+}
+
+template <typename T>
+SumResult<std::remove_const_t<T>> Sum(Span<T> values) {
+    using Element = std::remove_const_t<T>;
+    return vector_algorithms_detail::Dispatch<Element>([&](auto kernels) {
+        return decltype(kernels)::Sum(values.Data(), values.Size());
+    });
+}
+
+template <typename T>
+void Fill(Span<T> values, const std::remove_const_t<T>& value) {
+    static_assert(!std::is_const_v<T>, "Cannot fill a range of const elements");
+    vector_algorithms_detail::Dispatch<T>([&](auto kernels) {
+        decltype(kernels)::Fill(values.Data(), values.Size(), value);
+    });
+}
+
+template <typename T, typename U>
+bool Equal(Span<T> lhs, Span<U> rhs) {
+    using Element = std::remove_const_t<T>;
+    static_assert(std::is_same_v<Element, std::remove_const_t<U>>, "Equal compares ranges of the same element type");
+    if(lhs.Size() != rhs.Size()) {
+        return false;
+    }
+    return vector_algorithms_detail::Dispatch<Element>([&](auto kernels) {
+        return decltype(kernels)::Equal(lhs.Data(), rhs.Data(), lhs.Size());
+    });
+}
+
+// Перегрузки для Vector обрабатывают все его элементы
+
+template <typename T, typename... Params>
+typename Vector<T, Params...>::iterator Find(Vector<T, Params...>& vector, const vector_algorithms_detail::NonDeduced<T>& value) {
+    return vector.begin() + (Find(Span<T>(vector.Data(), vector.Size()), value) - vector.Data());
+}
+
+template <typename T, typename... Params>
+typename Vector<T, Params...>::const_iterator Find(const Vector<T, Params...>& vector, const vector_algorithms_detail::NonDeduced<T>& value) {
+    return vector.begin() + (Find(Span<const T>(vector.Data(), vector.Size()), value) - vector.Data());
+}
+
+template <typename T, typename... Params>
+size_t Count(const Vector<T, Params...>& vector, const vector_algorithms_detail::NonDeduced<T>& value) {
+    return Count(Span<const T>(vector.Data(), vector.Size()), value);
+}
+
+template <typename T, typename... Params>
+std::pair<T, T> MinMax(const Vector<T, Params...>& vector) {
+    return MinMax(Span<const T>(vector.Data(), vector.Size()));
+}
+
+template <typename T, typename... Params>
+SumResult<T> Sum(const Vector<T, Params...>& vector) {
+    return Sum(Span<const T>(vector.Data(), vector.Size()));
+}
+
+template <typename T, typename... Params>
+void Fill(Vector<T, Params...>& vector, const vector_algorithms_detail::NonDeduced<T>& value) {
+    Fill(Span<T>(vector.Data(), vector.Size()), value);
+}
+
+template <typename T, typename... LhsParams, typename... RhsParams>
+bool Equal(const Vector<T, LhsParams...>& lhs, const Vector<T, RhsParams...>& rhs) {
+    return Equal(Span<const T>(lhs.Data(), lhs.Size()), Span<const T>(rhs.Data(), rhs.Size()));
+}
@@ -0,0 +1,262 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <climits>
+#include <system_error>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+// Потоковое заполнение Vector из источников ввода. AppendFrom резервирует место один раз
+// и читает байты прямо в свободную ёмкость буфера, без промежуточных буферов, а размер
+// вектора увеличивается только на полностью полученные элементы. Элемент, чтение которого
+// разбилось на несколько порций, дочитывается. Элементы должны быть тривиально копируемыми
+// и записываются в порядке байтов источника.
+// Если поток закончился посреди элемента, выбрасывается VectorReadError, ошибки ввода
+// сообщаются std::system_error. В обоих случаях полученные до ошибки элементы остаются
+// в векторе
+
+class VectorReadError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+namespace vector_io_detail {
+
+// Обеспечивает место для count новых элементов с ростом по политике вектора, чтобы
+// серия AppendFrom не перераспределяла память при каждом вызове
+template <typename VectorType>
+void ReserveForAppend(VectorType& vector, size_t count) {
+    const size_t required = vector.Size() + count;
+    if(required > vector.Capacity()) {
+        using Growth = typename VectorType::growth_policy;
+        using T = std::remove_pointer_t<decltype(vector.Data())>;
+        vector.Reserve(std::max(required, Growth::NextCapacity(vector.Capacity(), required, sizeof(T))));
+    }
+}
+
+// Состояние одного AppendFrom: ёмкость под чтение и количество полученных байт
+template <typename VectorType>
+class AppendState {
+    using T = std::remove_pointer_t<decltype(std::declval<VectorType&>().Data())>;
+
+    static_assert(std::is_trivially_copyable_v<T>, "AppendFrom reads elements as raw bytes");
+
+public:
+    AppendState(VectorType& vector, size_t max_count) : vector_(vector), limit_(CheckedLimit(vector, max_count)) {
+        if(max_count != 0) {
+            ReserveForAppend(vector, max_count);
+        }
+    }
+
+    // Продолжать ли чтение: пока не получен хотя бы один элемент или последний получен не целиком
+    bool NeedsMore() const noexcept {
+        return limit_ != 0 && (received_ == 0 || received_ % sizeof(T) != 0);
+    }
+
+    unsigned char* Next() noexcept {
+        return reinterpret_cast<unsigned char*>(vector_.SpareCapacity()) + received_;
+    }
+
+    size_t Remaining() const noexcept {
+        return limit_ - received_;
+    }
+
+    void Received(size_t bytes) noexcept {
+        received_ += bytes;
+    }
+
+    // Добавляет в вектор полностью полученные элементы и возвращает их количество.
+    // Конец потока посреди элемента — ошибка
+    size_t Commit(bool end_of_stream) {
+        const size_t count = received_ / sizeof(T);
+        vector_.CommitAppend(count);
+        received_ -= count * sizeof(T);
+        if(end_of_stream && received_ != 0) {
+            throw VectorReadError("Stream ended inside an element");
+        }
+        return count;
+    }
+
+private:
+    // Размер чтения в байтах. Количество, не помещающееся в size_t ни в байтах, ни вместе
+    // с уже имеющимися элементами, сообщается исключением
+    static size_t CheckedLimit(const VectorType& vector, size_t max_count) {
+        if(max_count > SIZE_MAX / sizeof(T) - vector.Size()) {
+            throw std::length_error("AppendFrom count is too large");
+        }
+        return max_count * sizeof(T);
+    }
+
+    VectorType& vector_;
+    size_t limit_;
+    size_t received_ = 0;
+};
+
+}  // namespace vector_io_detail
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace vector_io_detail {
+
+// Сохраняет полученные элементы и сообщает ошибку ввода
+template <typename State>
+[[noreturn]] void Fail(State& state, int error, const char* what) {
+    state.Commit(false);
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+// Ждёт данных на неблокирующем дескрипторе. POLLHUP означает, что данные или конец потока
+// можно прочитать, а POLLERR и POLLNVAL — что следующий read не продвинется
+template <typename State>
+void WaitReadable(State& state, int fd) {
+    pollfd readable{fd, POLLIN, 0};
+    if(::poll(&readable, 1, -1) < 0) {
+        if(errno != EINTR) {
+            Fail(state, errno, "poll");
+        }
+    } else if(readable.revents & POLLNVAL) {
+        Fail(state, EBADF, "poll");
+    } else if((readable.revents & POLLERR) && !(readable.revents & (POLLIN | POLLHUP))) {
+        Fail(state, EIO, "poll");
+    }
+}
+
+}  // namespace vector_io_detail
+
+// Дописывает в vector от одного до max_count элементов, прочитанных из файлового
+// дескриптора fd, и возвращает их количество. Ждёт появления данных, в том числе
+// у неблокирующего дескриптора, и возвращает 0 только в конце потока
+template <typename T, typename... Params>
+size_t AppendFrom(Vector<T, Params...>& vector, int fd, size_t max_count) {
+    vector_io_detail::AppendState<Vector<T, Params...>> state(vector, max_count);
+    while(state.NeedsMore()) {
+        const ssize_t bytes = ::read(fd, state.Next(), std::min<size_t>(state.Remaining(), SSIZE_MAX));
+        if(bytes > 0) {
+            state.Received(static_cast<size_t>(bytes));
+        } else if(bytes == 0) {
+            return state.Commit(true);
+        } else if(errno == EAGAIN || errno == EWOULDBLOCK) {
+            vector_io_detail::WaitReadable(state, fd);
+        } else if(errno != EINTR) {
+            vector_io_detail::Fail(state, errno, "read");
+        }
+    }
+    return state.Commit(false);
+}
+
+#endif
+
+#if defined(__cpp_impl_coroutine)
+
+// Результат асинхронного AppendFrom: количество добавленных элементов. Чтение начинается
+// при co_await, а по его завершении управление возвращается ожидающей корутине
+class AppendTask {
+public:
+    struct promise_type {
+        AppendTask get_return_object() noexcept {
+            return AppendTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        auto final_suspend() noexcept {
+            struct ResumeContinuation {
+                bool await_ready() noexcept {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    return handle.promise().continuation;
+                }
+
+                void await_resume() noexcept {
+                }
+            };
+            return ResumeContinuation{};
+        }
+
+        void return_value(size_t count) noexcept {
+            result = count;
+        }
+
+        void unhandled_exception() noexcept {
+            error = std::current_exception();
+        }
+
+        std::coroutine_handle<> continuation;
+        size_t result = 0;
+        std::exception_ptr error;
+    };
+
+    AppendTask(AppendTask&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+    }
+
+    AppendTask& operator=(AppendTask&&) = delete;
+
+    ~AppendTask() {
+        if(handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+        handle_.promise().continuation = continuation;
+        return handle_;
+    }
+
+    size_t await_resume() {
+        if(handle_.promise().error) {
+            std::rethrow_exception(handle_.promise().error);
+        }
+        return handle_.promise().result;
+    }
+
+private:
+    explicit AppendTask(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// Как AppendFrom из дескриптора, но данные читает асинхронный источник: reader.ReadSome(data,
+// size) возвращает ожидаемый объект, результат которого — количество записанных в data байт,
+// не больше size, а 0 означает конец потока. Вектор и источник должны пережить ожидание,
+// и вектор нельзя изменять, пока оно не завершилось
+template <typename T, typename... Params, typename Reader, typename = std::enable_if_t<!std::is_integral_v<Reader>>>
+AppendTask AppendFrom(Vector<T, Params...>& vector, Reader& reader, size_t max_count) {
+    vector_io_detail::AppendState<Vector<T, Params...>> state(vector, max_count);
+    bool end_of_stream = false;
+    try {
+        while(state.NeedsMore() && !end_of_stream) {
+            const size_t bytes = co_await reader.ReadSome(static_cast<void*>(state.Next()), state.Remaining());
+            end_of_stream = bytes == 0;
+            state.Received(bytes);
+        }
+    } catch (...) {
+        state.Commit(false);
+        throw;
+    }
+    co_return state.Commit(end_of_stream);
+}
+
+#endif
@@ -0,0 +1,164 @@
+#pragma once
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <typeinfo>
+
+// Сводка статистики всех векторов с одним типом элементов
+struct VectorStatsSnapshot {
+    const char* type_name = nullptr;
+    size_t element_size = 0;
+    // Количество смен буфера: Reserve, рост при вставке и уменьшение ёмкости
+    uint64_t reallocations = 0;
+    // Объём элементов, перенесённых в новый буфер при сменах
+    uint64_t bytes_moved = 0;
+    // Наибольшая ёмкость одного вектора, в элементах
+    uint64_t peak_capacity = 0;
+    // Суммарная незанятая ёмкость буферов на момент отказа вектора от них, в байтах
+    uint64_t wasted_bytes = 0;
+    // Количество буферов, от которых отказались векторы: при разрушении, присваивании,
+    // ClearAndRelease, Release и Adopt
+    uint64_t releases = 0;
+    // Суммарное время смен буфера
+    std::chrono::nanoseconds reallocation_time{0};
+};
+
+// Политика учёта статистики для Vector<T, Alloc, Growth, VectorStats>. Счётчики общие
+// для всех векторов с элементами типа T и обновляются атомарно, поэтому векторы
+// можно использовать из разных потоков. Снимок доступен без подключения профилировщика:
+// VectorStats::Snapshot<T>() для одного типа или VectorStats::SnapshotAll() для всех
+// типов, статистика которых уже записывалась
+class VectorStats {
+    using Clock = std::chrono::steady_clock;
+
+    class Record {
+    public:
+        Record(const char* type_name, size_t element_size) noexcept
+            : type_name_(type_name), element_size_(element_size) {
+            next_ = head_.load(std::memory_order_relaxed);
+            while(!head_.compare_exchange_weak(next_, this, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+
+        void AddReallocation(size_t new_capacity, size_t moved, Clock::duration elapsed) noexcept {
+            reallocations_.fetch_add(1, std::memory_order_relaxed);
+            bytes_moved_.fetch_add(uint64_t{moved} * element_size_, std::memory_order_relaxed);
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            reallocation_ns_.fetch_add(static_cast<uint64_t>(ns), std::memory_order_relaxed);
+            uint64_t peak = peak_capacity_.load(std::memory_order_relaxed);
+            while(peak < new_capacity
+                  && !peak_capacity_.compare_exchange_weak(peak, new_capacity, std::memory_order_relaxed)) {
+            }
+        }
+
+        void AddRelease(size_t size, size_t capacity) noexcept {
+            releases_.fetch_add(1, std::memory_order_relaxed);
+            wasted_bytes_.fetch_add(uint64_t{capacity - size} * element_size_, std::memory_order_relaxed);
+            uint64_t peak = peak_capacity_.load(std::memory_order_relaxed);
+            while(peak < capacity && !peak_capacity_.compare_exchange_weak(peak, capacity, std::memory_order_relaxed)) {
+            }
+        }
+
+        VectorStatsSnapshot Snapshot() const noexcept {
+            VectorStatsSnapshot snapshot;
+            snapshot.type_name = type_name_;
+            snapshot.element_size = element_size_;
+            snapshot.reallocations = reallocations_.load(std::memory_order_relaxed);
+            snapshot.bytes_moved = bytes_moved_.load(std::memory_order_relaxed);
+            snapshot.peak_capacity = peak_capacity_.load(std::memory_order_relaxed);
+            snapshot.wasted_bytes = wasted_bytes_.load(std::memory_order_relaxed);
+            snapshot.releases = releases_.load(std::memory_order_relaxed);
+            snapshot.reallocation_time = std::chrono::nanoseconds(reallocation_ns_.load(std::memory_order_relaxed));
+            return snapshot;
+        }
+
+        void Reset() noexcept {
+            reallocations_.store(0, std::memory_order_relaxed);
+            bytes_moved_.store(0, std::memory_order_relaxed);
+            peak_capacity_.store(0, std::memory_order_relaxed);
+            wasted_bytes_.store(0, std::memory_order_relaxed);
+            releases_.store(0, std::memory_order_relaxed);
+            reallocation_ns_.store(0, std::memory_order_relaxed);
+        }
+
+        static const Record* Head() noexcept {
+            return head_.load(std::memory_order_acquire);
+        }
+
+        const Record* Next() const noexcept {
+            return next_;
+        }
+
+    private:
+        // Записи всех типов образуют односвязный список, пополняемый без блокировок
+        static inline std::atomic<Record*> head_{nullptr};
+
+        const char* type_name_;
+        size_t element_size_;
+        Record* next_ = nullptr;
+        std::atomic<uint64_t> reallocations_{0};
+        std::atomic<uint64_t> bytes_moved_{0};
+        std::atomic<uint64_t> peak_capacity_{0};
+        std::atomic<uint64_t> wasted_bytes_{0};
+        std::atomic<uint64_t> releases_{0};
+        std::atomic<uint64_t> reallocation_ns_{0};
+    };
+
+    template <typename T>
+    static Record& RecordFor() noexcept {
+        static Record record(typeid(T).name(), sizeof(T));
+        return record;
+    }
+
+public:
+    // Засекает время смены буфера и записывает её, только если она завершилась успешно
+    template <typename T>
+    class Probe {
+    public:
+        Probe() noexcept : start_(Clock::now()) {
+        }
+
+        void Commit(size_t /*old_capacity*/, size_t new_capacity, size_t moved) noexcept {
+            RecordFor<T>().AddReallocation(new_capacity, moved, Clock::now() - start_);
+        }
+
+    private:
+        Clock::time_point start_;
+    };
+
+    template <typename T>
+    static void OnRelease(size_t size, size_t capacity) noexcept {
+        if(capacity != 0) {
+            RecordFor<T>().AddRelease(size, capacity);
+        }
+    }
+
+    template <typename T>
+    static VectorStatsSnapshot Snapshot() noexcept {
+        return RecordFor<T>().Snapshot();
+    }
+
+    // Снимки всех типов, упорядоченные по убыванию числа смен буфера
+    static Vector<VectorStatsSnapshot> SnapshotAll() {
+        Vector<VectorStatsSnapshot> result;
+        for(const Record* record = Record::Head(); record != nullptr; record = record->Next()) {
+            result.PushBack(record->Snapshot());
+        }
+        std::sort(result.begin(), result.end(), [](const VectorStatsSnapshot& lhs, const VectorStatsSnapshot& rhs) {
+            return lhs.reallocations > rhs.reallocations;
+        });
+        return result;
+    }
+
+    template <typename T>
+    static void Reset() noexcept {
+        RecordFor<T>().Reset();
+    }
+};
+
+// Вектор, собирающий статистику смен буфера
+template <typename T, typename Alloc = std::allocator<T>, typename Growth = DoublingGrowth>
+using InstrumentedVector = Vector<T, Alloc, Growth, VectorStats>;